@@ -1,7 +1,12 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 0) uniform sampler2D TEXTURE_0;
+layout(set = 0, binding = 0) uniform sampler2D TEXTURES[];
+
+layout(push_constant) uniform TextureConstants {
+    layout(offset = 64) uint textureIndex;
+};
 
 layout(location = 0) out vec4 outColor;
 
@@ -22,7 +27,7 @@ void main() {
 
     vec3 result = diffuse + ambient;
 
-    vec4 color = texture(TEXTURE_0, coords);
+    vec4 color = texture(TEXTURES[nonuniformEXT(textureIndex)], coords);
 
 #ifdef ALPHA_TEST
 	if(color.a < 0.5)
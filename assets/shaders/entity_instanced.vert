@@ -0,0 +1,38 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+struct Instance {
+    mat4 model;
+    vec4 tint;
+    uint textureIndex;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(push_constant) uniform CameraUniform {
+    mat4 camera;
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inCoords;
+
+layout(location = 0) out vec3 vertex;
+layout(location = 1) out vec3 normal;
+layout(location = 2) out vec2 coords;
+layout(location = 3) out vec4 tint;
+layout(location = 4) flat out uint textureIndex;
+
+void main() {
+	Instance instance = instances[gl_InstanceIndex];
+
+	gl_Position = camera * instance.model * vec4(inPosition, 1.0);
+
+	vertex = inPosition;
+	normal = mat3(instance.model) * inNormal;
+	coords = inCoords;
+	tint = instance.tint;
+	textureIndex = instance.textureIndex;
+}
@@ -6,6 +6,8 @@
 
 #include "client/GameWindow.hpp"
 #include "client/Clock.hpp"
+#include "client/FrameLimiter.hpp"
+#include "client/Benchmark.hpp"
 #include "client/Mouse.hpp"
 #include "client/Keyboard.hpp"
 #include "client/gui/gui.hpp"
@@ -16,16 +18,28 @@
 #include "src/client/renderer/EntityRenderer.hpp"
 #include "client/renderer/texture/TextureManager.hpp"
 #include "client/renderer/texture/TextureAtlas.hpp"
+#include "client/renderer/texture/BlockTextureArray.hpp"
 #include "client/renderer/material/MaterialManager.hpp"
 #include "client/renderer/model/ModelFormat.hpp"
 #include "client/renderer/Colormap.hpp"
 
 #include "client/renderer/BlockTessellator.hpp"
+#include "client/renderer/culling/FrustumCuller.hpp"
+#include "client/renderer/culling/OcclusionCuller.hpp"
+#include "client/renderer/culling/GpuCuller.hpp"
+
+#include "client/util/PngWriter.hpp"
+#include "util/ThreadPool.hpp"
 
 #include "world/tile/Tile.hpp"
 
 #include "nlohmann/json.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include <fmt/format.h>
+
 using Json = nlohmann::json;
 
 struct Camera {
@@ -66,39 +80,74 @@ private:
 	glm::mat4 _projection;
 };
 
+// the names are the values accepted by --present-mode
+struct PresentModeOption {
+	const char* name;
+	vk::PresentModeKHR mode;
+};
+
+inline constexpr PresentModeOption PresentModes[] {
+	{"fifo", vk::PresentModeKHR::eFifo},
+	{"fifo-relaxed", vk::PresentModeKHR::eFifoRelaxed},
+	{"mailbox", vk::PresentModeKHR::eMailbox},
+	{"immediate", vk::PresentModeKHR::eImmediate}
+};
+
 struct GameClient {
 	RenderSystem* core = RenderSystem::Instance();
 
 	~GameClient() {
 		core->device().waitIdle();
+		gpuCuller.destroy();
 	}
 
-	void init(GameWindow& window) {
-		core->init(window.getPlatformWindow());
+	// without a window the client renders offscreen at the given size and has no gui
+	void init(GLFWwindow* window, vk::Extent2D size) {
+		core->init(window);
 
 		platform = std::make_unique<AppPlatform>();
-		renderContext = std::make_unique<RenderContext>();
+		renderContext = std::make_unique<RenderContext>(size);
 
 		resourceManager = std::make_unique<ResourceManager>();
 		textureManager = std::make_unique<TextureManager>(renderContext, resourceManager);
+		textureManager->enableCompression("cache/textures");
 		materialManager = std::make_unique<MaterialManager>();
 
-		resourceManager->addResourcePack(std::make_unique<ResourcePack>("assets/resource_packs/vanilla"));
-		materialManager->loadMetaFile(platform, renderContext);
+		// an archive built by vcraft_pack is preferred over the loose files it was built from
+		if (std::filesystem::exists("assets/resource_packs/vanilla.vpack")) {
+			resourceManager->addResourcePack("assets/resource_packs/vanilla.vpack");
+		} else {
+			resourceManager->addResourcePack("assets/resource_packs/vanilla");
+		}
+		materialManager->loadMetaFile(resourceManager, platform, renderContext);
+		gpuCuller.create(platform, renderContext);
+		if (useGpuCulling && !core->gpuCullingSupported()) {
+			std::cout << "gpu culling is not supported by this device, culling on the cpu" << std::endl;
+			useGpuCulling = false;
+		}
 
 		loadEntities();
 		loadModels();
 
-		atlas = std::make_unique<TextureAtlas>();
-		atlas->loadMetaFile(resourceManager);
-		textureManager->upload("textures/blocks", atlas);
+		if (useBlockTextureArray) {
+			blockTextures = std::make_unique<BlockTextureArray>();
+			blockTextures->loadMetaFile(resourceManager);
+			textureManager->upload("textures/blocks", blockTextures);
+		} else {
+			atlas = std::make_unique<TextureAtlas>();
+			atlas->enableCache("cache/atlas");
+			atlas->loadMetaFile(resourceManager);
+			textureManager->upload("textures/blocks", atlas);
+		}
 
 		loadBlocks();
 		Colormap::initColormaps(resourceManager);
 		Tile::initTiles(textureManager);
 
 		camera = std::make_unique<Camera>(platform.get());
-		gui = std::make_unique<GUI>(window.getPlatformWindow(), renderContext);
+		if (window != nullptr) {
+			gui = std::make_unique<GUI>(window, renderContext);
+		}
 	}
 
 	void loadEntities() {
@@ -232,13 +281,13 @@ struct GameClient {
 		std::filesystem::directory_entry directory("models");
 
 		for (auto& resources : resourceManager->getResources("models")) {
-			parseModels(Json::parse(resources));
+			parseModels(Json::parse(resources.begin(), resources.end()));
 		}
 
 		auto material = materialManager->getMaterial("entity_static");
 		material->SetTexture(textureManager->getTexture("textures/entity/bed/white"));
 
-		agentRenderer = std::make_unique<EntityRenderer>(material, models.at("geometry.bed"));
+		agentRenderer = std::make_unique<EntityRenderer>(renderContext, material, models.at("geometry.bed"));
 	}
 
 	void loadBlocks() {
@@ -258,6 +307,8 @@ struct GameClient {
 	}
 
 	void tick() {
+		// sleeping before input is polled keeps the limiter from adding latency to the frame it delays
+		frameLimiter.wait();
 		clock.update();
 
 		Mouse::update();
@@ -276,30 +327,160 @@ struct GameClient {
 			.camera = proj * glm::translate(view, -position)
 		};
 
-		gui->begin();
-		ImGui::SetNextWindowPos(ImVec2(0, 0));
-		ImGui::Begin("Test", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoTitleBar);
-//		ImGui::Image(atlas->renderTexture, ImVec2(512, 512));
-		ImGui::End();
-		gui->end();
-
-		auto cmd = renderContext->begin();
-		cmd.setViewport(0, 1, &viewport);
-		cmd.setScissor(0, 1, &scissor);
-		agentRenderer->render(cmd, transform);
-		gui->draw(cmd);
+		// every drawable registers its bounds, the draws below only run for the indices that survive the frustum
+		frustumCuller.clear();
+		const auto agentIndex = frustumCuller.add(agentRenderer->bounds);
+
+		// the remaining entities are copies of the agent laid out on a grid around it, drawn with one instanced draw
+		const auto firstCopyIndex = agentIndex + 1;
+		const int side = int(std::ceil(std::sqrt(float(entityCount))));
+		for (int i = 1; i < entityCount; i++) {
+			frustumCuller.add(_offsetBounds(agentRenderer->bounds, _gridOffset(i, side)));
+		}
+
+		visibleDraws.clear();
+		frustumCuller.cull(Frustum::extract(transform), visibleDraws);
+
+		// nothing registers occluders until world geometry is rendered, so this only filters the entity draws for now
+		occlusionCuller.begin(transform.camera);
+		const bool agentVisible = std::binary_search(visibleDraws.begin(), visibleDraws.end(), agentIndex) && occlusionCuller.isVisible(agentRenderer->bounds);
+
+		// draws are collected and sorted by state before any command is recorded
+		renderQueue.clear();
+		if (!useGpuCulling && agentVisible) {
+			auto center = glm::vec3(
+				(agentRenderer->bounds.minX + agentRenderer->bounds.maxX) * 0.5f,
+				(agentRenderer->bounds.minY + agentRenderer->bounds.maxY) * 0.5f,
+				(agentRenderer->bounds.minZ + agentRenderer->bounds.maxZ) * 0.5f
+			);
+			agentRenderer->submit(renderQueue, transform, glm::length(center - position));
+		}
+		// the gpu path only takes over the agent's own draw, the copies keep their frustum culled instanced draw
+		// so both paths draw the same entities
+		if (entityCount > 1) {
+			instances.clear();
+			for (auto index : visibleDraws) {
+				if (index < firstCopyIndex) {
+					continue;
+				}
+				auto offset = _gridOffset(int(index - agentIndex), side);
+				instances.emplace_back(InstanceData{
+					.model = glm::translate(glm::mat4(1.0f), offset),
+					.tint = glm::vec4(1.0f),
+					.textureIndex = agentRenderer->textureIndex()
+				});
+			}
+			if (!instances.empty()) {
+				auto center = glm::vec3(
+					(agentRenderer->bounds.minX + agentRenderer->bounds.maxX) * 0.5f,
+					(agentRenderer->bounds.minY + agentRenderer->bounds.maxY) * 0.5f,
+					(agentRenderer->bounds.minZ + agentRenderer->bounds.maxZ) * 0.5f
+				);
+				agentRenderer->submitInstances(renderQueue, renderContext->instanceBuffer, renderContext->frameIndex, transform, instances, glm::length(center - position));
+			}
+		}
+		renderQueue.sort();
+
+		// the gpu path tests the same bounds on the device and draws whatever it keeps through one indirect count draw
+		gpuCuller.enabled = useGpuCulling;
+		if (useGpuCulling) {
+			auto& bounds = agentRenderer->bounds;
+			GpuDrawBounds drawBounds[] {
+				{glm::vec4(bounds.minX, bounds.minY, bounds.minZ, 1.0f), glm::vec4(bounds.maxX, bounds.maxY, bounds.maxZ, 1.0f)}
+			};
+			vk::DrawIndexedIndirectCommand drawCommands[] {
+				{.indexCount = agentRenderer->indexCount(), .instanceCount = 1, .firstIndex = 0, .vertexOffset = 0, .firstInstance = 0}
+			};
+			gpuCuller.setDraws(drawBounds, drawCommands);
+			gpuCuller.setViewProjection(transform.camera);
+		}
+
+		if (gui) {
+			gui->begin();
+			ImGui::SetNextWindowPos(ImVec2(0, 0));
+			ImGui::Begin("Test", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoTitleBar);
+//			ImGui::Image(atlas->renderTexture, ImVec2(512, 512));
+			if (ImGui::Checkbox("Low latency", &lowLatency)) {
+				renderContext->setLatencyMode(lowLatency ? LatencyMode::Low : LatencyMode::Default);
+			}
+			if (ImGui::Combo("Present mode", &presentModeIndex, [](void*, int index, const char** name) { *name = PresentModes[index].name; return true; }, nullptr, int(std::size(PresentModes)))) {
+				renderContext->setPresentMode(PresentModes[presentModeIndex].mode);
+			}
+			if (renderContext->presentMode != PresentModes[presentModeIndex].mode) {
+				ImGui::Text("Unsupported, using %s", _presentModeName(renderContext->presentMode));
+			}
+			if (ImGui::SliderInt("FPS limit", &fpsLimit, 0, 480, fpsLimit == 0 ? "Off" : "%d")) {
+				frameLimiter.setTargetFps(fpsLimit);
+			}
+			if (core->gpuCullingSupported()) {
+				ImGui::Checkbox("GPU culling", &useGpuCulling);
+			}
+			drawDynamicResolution();
+			ImGui::SliderInt("Entities", &entityCount, 1, 4096);
+			drawProfiler();
+			ImGui::End();
+			gui->end();
+		}
+
+		DrawGroup scenePasses[] {
+			{"entities", [&](vk::CommandBuffer cmd) {
+				cmd.setViewport(0, 1, &viewport);
+				cmd.setScissor(0, 1, &scissor);
+				renderQueue.record(cmd);
+				if (useGpuCulling) {
+					agentRenderer->renderIndirect(cmd, transform, gpuCuller);
+				}
+			}}
+		};
+		DrawGroup overlayPasses[] {
+			{"gui", [&](vk::CommandBuffer cmd) {
+				gui->draw(cmd);
+			}}
+		};
+
+		renderContext->begin();
+
+		// the render area is only known once begin picked this frame's resolution scale
+		viewport.width = float(renderContext->renderArea.extent.width);
+		viewport.height = float(renderContext->renderArea.extent.height);
+		scissor.extent = renderContext->renderArea.extent;
+
+		renderContext->execute(scenePasses);
+		renderContext->beginOverlay();
+		if (gui) {
+			renderContext->execute(overlayPasses);
+		}
 		renderContext->end();
 	}
 
+	void setCamera(const glm::vec3& cameraPosition, float yaw, float pitch) {
+		position = cameraPosition;
+		rotationYaw = yaw;
+		rotationPitch = pitch;
+	}
+
+	Handle<RenderContext> getRenderContext() {
+		return renderContext;
+	}
+
 	void setRenderSize(int width, int height) {
 		renderContext->setRenderSize(width, height);
 		camera->setRenderSize(width, height);
+	}
 
-		viewport.width = width;
-		viewport.height = height;
+	// unknown names keep the current mode
+	void setPresentMode(std::string_view name) {
+		for (int i = 0; i < int(std::size(PresentModes)); i++) {
+			if (name == PresentModes[i].name) {
+				presentModeIndex = i;
+				renderContext->setPresentMode(PresentModes[i].mode);
+			}
+		}
+	}
 
-		scissor.extent.width = width;
-		scissor.extent.height = height;
+	void setFpsLimit(int fps) {
+		fpsLimit = std::max(fps, 0);
+		frameLimiter.setTargetFps(fpsLimit);
 	}
 
 	void quit() {
@@ -309,7 +490,86 @@ struct GameClient {
 	bool wantToQuit() {
 		return !_running;
 	}
+
+	// selects the layered block texture backend instead of the 2d atlas, must be set before init
+	bool useBlockTextureArray{false};
+	// culls and compacts draws in a compute pass instead of on the cpu, ignored when the device can't draw indirect
+	bool useGpuCulling{false};
+	// how many copies of the agent to draw, everything past the first goes through the instanced path
+	int entityCount{1};
 private:
+	// grid cells are two blocks apart, cell 0 is the agent itself
+	static glm::vec3 _gridOffset(int index, int side) {
+		return glm::vec3(float(index % side) * 2.0f, 0.0f, float(index / side) * 2.0f);
+	}
+
+	static const char* _presentModeName(vk::PresentModeKHR mode) {
+		for (auto& option : PresentModes) {
+			if (option.mode == mode) {
+				return option.name;
+			}
+		}
+		return "unknown";
+	}
+
+	static AABB _offsetBounds(const AABB& bounds, const glm::vec3& offset) {
+		return AABB{
+			bounds.minX + offset.x, bounds.minY + offset.y, bounds.minZ + offset.z,
+			bounds.maxX + offset.x, bounds.maxY + offset.y, bounds.maxZ + offset.z
+		};
+	}
+
+	void drawDynamicResolution() {
+		auto& dynamicResolution = renderContext->dynamicResolution;
+
+		ImGui::Checkbox("Dynamic resolution", &dynamicResolution.enabled);
+		if (dynamicResolution.enabled) {
+			float target = float(dynamicResolution.targetFrameTime);
+			if (ImGui::SliderFloat("Target GPU time (ms)", &target, 2.0f, 50.0f, "%.1f")) {
+				dynamicResolution.targetFrameTime = target;
+			}
+		}
+		auto extent = renderContext->renderArea.extent;
+		ImGui::Text("Render scale %.0f%% (%ux%u)", dynamicResolution.scale * 100.0f, extent.width, extent.height);
+	}
+
+	void drawProfiler() {
+		auto& profiler = renderContext->profiler;
+
+		if (!ImGui::CollapsingHeader("GPU profiler")) {
+			return;
+		}
+
+		ImGui::Text("cpu %.2f ms, gpu %.2f ms", clock.deltaSeconds() * 1000.0f, renderContext->gpuFrameTime);
+
+		auto& queueStats = renderQueue.stats();
+		ImGui::Text("%u draws, %u pipeline binds, %u set binds", queueStats.draws, queueStats.pipelineBinds, queueStats.descriptorSetBinds);
+
+		for (auto& history : profiler.history()) {
+			auto last = (profiler.historyOffset() + GpuProfiler::HistorySize - 1) % GpuProfiler::HistorySize;
+			auto overlay = fmt::format("{:.3f} ms", history.times[last]);
+			ImGui::PlotLines(std::string(history.name).c_str(), history.times.data(), int(history.times.size()), int(profiler.historyOffset()), overlay.c_str(), 0.0f, FLT_MAX, ImVec2(240, 40));
+		}
+
+		for (auto& scope : profiler.latest.scopes) {
+			if (scope.statistics.vertexShaderInvocations == 0 && scope.statistics.fragmentShaderInvocations == 0) {
+				continue;
+			}
+			ImGui::Text("%.*s: %llu prims, %llu vs, %llu fs", int(scope.name.size()), scope.name.data(),
+				(unsigned long long) scope.statistics.clippingPrimitives,
+				(unsigned long long) scope.statistics.vertexShaderInvocations,
+				(unsigned long long) scope.statistics.fragmentShaderInvocations);
+		}
+
+		if (ImGui::Checkbox("Record", &profilerRecording)) {
+			profiler.setRecording(profilerRecording);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Export CSV")) {
+			profiler.writeCsv("gpu_profile.csv");
+		}
+	}
+
 	glm::mat4 rotationMatrix() {
 		float yaw = glm::radians(rotationYaw);
 		float pitch = glm::radians(rotationPitch);
@@ -369,10 +629,18 @@ private:
 	std::unique_ptr<TextureManager> textureManager;
 	std::unique_ptr<EntityRenderer> agentRenderer;
 	std::unique_ptr<TextureAtlas> atlas;
+	std::unique_ptr<BlockTextureArray> blockTextures;
 
 	std::unique_ptr<Camera> camera;
 	std::unique_ptr<GUI> gui;
 
+	FrustumCuller frustumCuller;
+	std::vector<InstanceData> instances;
+	OcclusionCuller occlusionCuller;
+	std::vector<uint32_t> visibleDraws;
+	GpuCuller gpuCuller;
+	RenderQueue renderQueue;
+
 	vk::Viewport viewport{
 		.x = 0,
 		.y = 0,
@@ -388,10 +656,84 @@ private:
 	float rotationYaw{0};
 	float rotationPitch{0};
 
+	bool lowLatency{false};
+	int presentModeIndex{0};
+	int fpsLimit{0};
+	FrameLimiter frameLimiter;
+	bool profilerRecording{false};
 	bool _running{true};
 };
 
-int main(int, char**) {
+int runBenchmark(const BenchmarkOptions& options) {
+	auto cameraPath = options.cameraPath.empty() ? CameraPath::orbit(10.0f) : CameraPath::load(options.cameraPath);
+	if (!cameraPath) {
+		std::cout << "failed to load camera path " << options.cameraPath << std::endl;
+		return 1;
+	}
+
+	if (!options.captureDirectory.empty()) {
+		std::filesystem::create_directories(options.captureDirectory);
+	}
+
+	GameClient client{};
+	client.useBlockTextureArray = options.blockTextureArray;
+	client.useGpuCulling = options.gpuCulling;
+	client.entityCount = std::max(1, int(options.entities));
+	client.init(nullptr, {options.width, options.height});
+	client.setRenderSize(int(options.width), int(options.height));
+
+	auto renderContext = client.getRenderContext();
+	if (options.targetFrameTime > 0.0) {
+		renderContext->dynamicResolution.enabled = true;
+		renderContext->dynamicResolution.targetFrameTime = options.targetFrameTime;
+	}
+	if (!options.profilePath.empty()) {
+		renderContext->profiler.setRecording(true);
+	}
+
+	BenchmarkTimings timings;
+	for (uint32_t frame = 0; frame < options.frames; frame++) {
+		auto keyframe = cameraPath->sample(float(frame) * options.timeStep);
+		client.setCamera(keyframe.position, keyframe.yaw, keyframe.pitch);
+
+		if (options.captureInterval != 0 && !options.captureDirectory.empty() && frame % options.captureInterval == 0) {
+			auto path = options.captureDirectory / fmt::format("frame_{:05}.png", frame);
+			// the callback runs inside begin(), so it only copies the pixels out and leaves encoding and writing to the
+			// workers. the pool finishes queued tasks before it shuts down, captures delivered at teardown are written too
+			renderContext->requestCapture([path](uint32_t width, uint32_t height, const void* pixels) {
+				auto bytes = static_cast<const uint8_t*>(pixels);
+				auto copy = std::make_shared<std::vector<uint8_t>>(bytes, bytes + size_t(width) * height * 4);
+				ThreadPool::Instance()->async([path, width, height, copy] {
+					PngWriter::write(path, width, height, 4, copy->data());
+				});
+			});
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		client.render();
+		auto cpu_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		timings.add(frame, cpu_time, renderContext->gpuFrameTime);
+	}
+
+	if (!timings.writeCsv(options.timingsPath)) {
+		std::cout << "failed to write " << options.timingsPath << std::endl;
+		return 1;
+	}
+
+	if (!options.profilePath.empty() && !renderContext->profiler.writeCsv(options.profilePath)) {
+		std::cout << "failed to write " << options.profilePath << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	auto options = BenchmarkOptions::parse(argc, argv);
+	if (options.headless) {
+		return runBenchmark(options);
+	}
+
 	GameWindow window("Vulkan", 1280, 720);
 	window.setMouseButtonCallback(&Mouse::handleMouseButton);
 	window.setMousePositionCallback(&Mouse::handleMousePosition);
@@ -401,8 +743,24 @@ int main(int, char**) {
 	window.getWindowSize(width, height);
 
 	GameClient client{};
-	client.init(window);
+	client.useBlockTextureArray = options.blockTextureArray;
+	client.useGpuCulling = options.gpuCulling;
+	client.entityCount = std::max(1, int(options.entities));
+	client.init(window.getPlatformWindow(), {uint32_t(width), uint32_t(height)});
 	client.setRenderSize(width, height);
+	client.setPresentMode(options.presentMode);
+	client.setFpsLimit(options.fpsLimit);
+	if (options.targetFrameTime > 0.0) {
+		client.getRenderContext()->dynamicResolution.enabled = true;
+		client.getRenderContext()->dynamicResolution.targetFrameTime = options.targetFrameTime;
+	}
+
+	// a minimized window reports a zero size, there is no swapchain to render into until it is restored
+	window.setWindowSizeCallback([&](int w, int h) {
+		if (w > 0 && h > 0) {
+			client.setRenderSize(w, h);
+		}
+	});
 
 	while (!window.shouldClose()) {
 		if (client.wantToQuit()) {
@@ -410,6 +768,12 @@ int main(int, char**) {
 			break;
 		}
 
+		window.getWindowSize(width, height);
+		if (width == 0 || height == 0) {
+			window.waitEvents();
+			continue;
+		}
+
 		client.tick();
 		client.render();
 	}
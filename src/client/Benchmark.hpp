@@ -0,0 +1,184 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "nlohmann/json.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct CameraKeyframe {
+	float time;
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+};
+
+// scripted camera movement, keyframes are linearly interpolated and must be sorted by time
+struct CameraPath {
+	std::vector<CameraKeyframe> keyframes;
+
+	static std::optional<CameraPath> load(const std::filesystem::path& path) {
+		std::ifstream ifs(path);
+		if (!ifs) {
+			return std::nullopt;
+		}
+
+		auto object = nlohmann::json::parse(ifs);
+
+		CameraPath cameraPath;
+		for (auto& keyframe : object.at("keyframes")) {
+			auto& position = keyframe.at("position");
+
+			cameraPath.keyframes.emplace_back(CameraKeyframe{
+				.time = keyframe.at("time").get<float>(),
+				.position = {position.at(0).get<float>(), position.at(1).get<float>(), position.at(2).get<float>()},
+				.yaw = keyframe.value("yaw", 0.0f),
+				.pitch = keyframe.value("pitch", 0.0f)
+			});
+		}
+		return cameraPath;
+	}
+
+	// a slow turn around the spawn point, used when no path file is given
+	static CameraPath orbit(float duration) {
+		CameraPath cameraPath;
+		for (int i = 0; i <= 8; i++) {
+			auto angle = glm::radians(45.0f * float(i));
+			cameraPath.keyframes.emplace_back(CameraKeyframe{
+				.time = duration * float(i) / 8.0f,
+				.position = {glm::sin(angle) * 3.0f, 1.5f, -glm::cos(angle) * 3.0f},
+				.yaw = 45.0f * float(i),
+				.pitch = -10.0f
+			});
+		}
+		return cameraPath;
+	}
+
+	float duration() const {
+		return keyframes.empty() ? 0.0f : keyframes.back().time;
+	}
+
+	CameraKeyframe sample(float time) const {
+		if (keyframes.empty()) {
+			return {};
+		}
+		if (time <= keyframes.front().time) {
+			return keyframes.front();
+		}
+
+		for (size_t i = 1; i < keyframes.size(); i++) {
+			auto& a = keyframes[i - 1];
+			auto& b = keyframes[i];
+			if (time <= b.time) {
+				auto t = b.time > a.time ? (time - a.time) / (b.time - a.time) : 1.0f;
+				return {
+					.time = time,
+					.position = glm::mix(a.position, b.position, t),
+					.yaw = glm::mix(a.yaw, b.yaw, t),
+					.pitch = glm::mix(a.pitch, b.pitch, t)
+				};
+			}
+		}
+		return keyframes.back();
+	}
+};
+
+struct BenchmarkOptions {
+	bool headless = false;
+	uint32_t width = 1280;
+	uint32_t height = 720;
+	uint32_t frames = 600;
+	// the camera path is sampled at a fixed step so runs are comparable regardless of frame time
+	float timeStep = 1.0f / 60.0f;
+	std::filesystem::path cameraPath;
+	std::filesystem::path timingsPath = "benchmark.csv";
+	std::filesystem::path profilePath;
+	std::filesystem::path captureDirectory;
+	uint32_t captureInterval = 0;
+	// also read by the windowed client
+	bool blockTextureArray = false;
+	bool gpuCulling = false;
+	uint32_t entities = 1;
+	// gpu frame time in milliseconds that dynamic resolution aims for, 0 renders at native resolution
+	double targetFrameTime = 0.0;
+	// windowed only, headless frames are never presented. fifo, fifo-relaxed, mailbox or immediate
+	std::string presentMode = "fifo";
+	int fpsLimit = 0;
+
+	// --headless [--size WxH] [--frames N] [--camera-path file.json] [--timings file.csv] [--profile file.csv] [--capture dir] [--capture-every N] [--entities N] [--dynamic-resolution ms]
+	static BenchmarkOptions parse(int argc, char** argv) {
+		BenchmarkOptions options;
+		for (int i = 1; i < argc; i++) {
+			auto arg = std::string_view(argv[i]);
+			auto next = [&]() -> const char* {
+				return i + 1 < argc ? argv[++i] : "";
+			};
+
+			if (arg == "--headless") {
+				options.headless = true;
+			} else if (arg == "--block-texture-array") {
+				options.blockTextureArray = true;
+			} else if (arg == "--gpu-culling") {
+				options.gpuCulling = true;
+			} else if (arg == "--entities") {
+				options.entities = std::strtoul(next(), nullptr, 10);
+			} else if (arg == "--dynamic-resolution") {
+				options.targetFrameTime = std::strtod(next(), nullptr);
+			} else if (arg == "--present-mode") {
+				options.presentMode = next();
+			} else if (arg == "--fps-limit") {
+				options.fpsLimit = std::atoi(next());
+			} else if (arg == "--size") {
+				std::sscanf(next(), "%ux%u", &options.width, &options.height);
+			} else if (arg == "--frames") {
+				options.frames = std::strtoul(next(), nullptr, 10);
+			} else if (arg == "--camera-path") {
+				options.cameraPath = next();
+			} else if (arg == "--timings") {
+				options.timingsPath = next();
+			} else if (arg == "--profile") {
+				options.profilePath = next();
+			} else if (arg == "--capture") {
+				options.captureDirectory = next();
+			} else if (arg == "--capture-every") {
+				options.captureInterval = std::strtoul(next(), nullptr, 10);
+			}
+		}
+		return options;
+	}
+};
+
+struct FrameTiming {
+	uint32_t frame;
+	double cpuTime;
+	double gpuTime;
+};
+
+// per-frame timings in milliseconds, gpu times lag behind by the number of frames in flight
+struct BenchmarkTimings {
+	std::vector<FrameTiming> frames;
+
+	void add(uint32_t frame, double cpuTime, double gpuTime) {
+		frames.emplace_back(FrameTiming{frame, cpuTime, gpuTime});
+	}
+
+	bool writeCsv(const std::filesystem::path& path) const {
+		std::ofstream ofs(path);
+		if (!ofs) {
+			return false;
+		}
+
+		ofs << "frame,cpu_ms,gpu_ms\n";
+		for (auto& timing : frames) {
+			ofs << timing.frame << ',' << timing.cpuTime << ',' << timing.gpuTime << '\n';
+		}
+		return bool(ofs);
+	}
+};
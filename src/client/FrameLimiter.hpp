@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+// paces frames to a target rate. sleep_until can overshoot by a scheduler tick, so the last stretch before
+// the deadline is spent yielding instead
+struct FrameLimiter {
+	using clock = std::chrono::steady_clock;
+
+	inline static constexpr auto SpinTime = std::chrono::milliseconds(2);
+
+	// 0 disables the limiter
+	void setTargetFps(int fps) {
+		targetFps = fps;
+		interval = fps > 0 ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / fps)) : clock::duration::zero();
+		deadline = clock::now();
+	}
+
+	int getTargetFps() const {
+		return targetFps;
+	}
+
+	void wait() {
+		if (interval == clock::duration::zero()) {
+			return;
+		}
+
+		auto now = clock::now();
+
+		// a frame that ran past a whole interval starts a new schedule instead of rushing the following ones
+		if (now - deadline > interval) {
+			deadline = now;
+			return;
+		}
+
+		if (deadline - now > SpinTime) {
+			std::this_thread::sleep_until(deadline - SpinTime);
+		}
+		while (clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+		deadline += interval;
+	}
+
+private:
+	int targetFps = 0;
+	clock::duration interval{};
+	clock::time_point deadline{};
+};
@@ -31,7 +31,7 @@ public:
 		glfwInit();
 		glfwDefaultWindowHints();
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
 		window = glfwCreateWindow(width, height, title, NULL, NULL);
 
@@ -56,6 +56,11 @@ public:
 		glfwGetFramebufferSize(window, &width, &height);
 	}
 
+	// blocks until an event arrives, used while there is nothing to render into
+	void waitEvents() {
+		glfwWaitEvents();
+	}
+
 	void close() {
 		glfwSetWindowShouldClose(window, GLFW_TRUE);
 	}
@@ -141,8 +141,9 @@ GUI::GUI(GLFWwindow* window, Handle<RenderContext> renderContext) : _window(wind
     _mouseCursors[ImGuiMouseCursor_NotAllowed] = glfwCreateStandardCursor(GLFW_ARROW_CURSOR);
 #endif
 
+	// sized for the upper bound so that changing the frames in flight never reuses a buffer still in use
 	_frameIndex = 0;
-	_frameCount = renderContext->frameCount;
+	_frameCount = RenderContext::MaxFramesInFlight;
 	_renderBuffers.resize(_frameCount);
 
 	ImGui::StyleColorsDark();
@@ -308,7 +309,7 @@ GUI::GUI(GLFWwindow* window, Handle<RenderContext> renderContext) : _window(wind
 		.pColorBlendState = &colorBlendState,
 		.pDynamicState = &dynamicState,
 		.layout = _pipelineLayout,
-		.renderPass = renderContext->renderPass,
+		.renderPass = renderContext->overlayRenderPass,
 	};
 
 	core->device().createGraphicsPipelines(nullptr, 1, &pipeline_create_info, nullptr, &_pipeline);
@@ -417,11 +418,11 @@ void GUI::draw(vk::CommandBuffer cmd) {
 	auto rb = &_renderBuffers[_frameIndex];
 
 	if (draw_data->TotalVtxCount > 0) {
-		rb->SetVertexBufferCount(draw_data->TotalVtxCount, sizeof(ImDrawVert));
-		rb->SetIndexBufferCount(draw_data->TotalIdxCount, sizeof(ImDrawIdx));
+		rb->ReserveVertexBuffer(draw_data->TotalVtxCount, sizeof(ImDrawVert));
+		rb->ReserveIndexBuffer(draw_data->TotalIdxCount, sizeof(ImDrawIdx));
 
-		auto vtx_dst = static_cast<ImDrawVert *>(rb->VertexBuffer.map());
-		auto idx_dst = static_cast<ImDrawIdx *>(rb->IndexBuffer.map());
+		auto vtx_dst = static_cast<ImDrawVert *>(rb->VertexData);
+		auto idx_dst = static_cast<ImDrawIdx *>(rb->IndexData);
 
 		for (int n = 0; n < draw_data->CmdListsCount; n++) {
 			auto cmd_list = draw_data->CmdLists[n];
@@ -431,8 +432,7 @@ void GUI::draw(vk::CommandBuffer cmd) {
 			idx_dst += cmd_list->IdxBuffer.Size;
 		}
 
-		rb->VertexBuffer.unmap();
-		rb->IndexBuffer.unmap();
+		rb->Flush();
 	}
 
 	setupRenderState(draw_data, cmd, rb, fb_width, fb_height);
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "RenderSystem.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/format.h>
+
+// global, update-after-bind arrays of sampled textures, draws select a texture by index.
+// binding 0 holds 2d textures, binding 1 holds 2d array textures
+struct BindlessTextures {
+	inline static constexpr uint32_t MaxTextures = 4096;
+	inline static constexpr uint32_t MaxTextureArrays = 64;
+	inline static constexpr uint32_t InvalidIndex = ~0u;
+
+	enum Binding : uint32_t {
+		Texture2D = 0,
+		Texture2DArray = 1
+	};
+
+	vk::DescriptorPool descriptorPool;
+	vk::DescriptorSetLayout descriptorSetLayout;
+	vk::DescriptorSet descriptorSet;
+	vk::Sampler sampler;
+
+	void create() {
+		auto core = RenderSystem::Instance();
+
+		auto properties = core->physicalDevice().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+		auto& properties12 = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+
+		auto limit = std::min(
+			properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			properties12.maxPerStageDescriptorUpdateAfterBindSamplers
+		);
+
+		slots[Texture2DArray].capacity = std::min(MaxTextureArrays, limit / 2);
+		slots[Texture2D].capacity = std::min(MaxTextures, limit - slots[Texture2DArray].capacity);
+
+		vk::SamplerCreateInfo samplerCreateInfo{
+			.magFilter = vk::Filter::eNearest,
+			.minFilter = vk::Filter::eNearest,
+			.mipmapMode = vk::SamplerMipmapMode::eNearest,
+			.addressModeU = vk::SamplerAddressMode::eRepeat,
+			.addressModeV = vk::SamplerAddressMode::eRepeat,
+			.addressModeW = vk::SamplerAddressMode::eRepeat,
+			.maxAnisotropy = 0,
+			.minLod = 0,
+			.maxLod = VK_LOD_CLAMP_NONE
+		};
+		sampler = core->device().createSampler(samplerCreateInfo, nullptr);
+
+		vk::DescriptorPoolSize poolSize{vk::DescriptorType::eCombinedImageSampler, slots[Texture2D].capacity + slots[Texture2DArray].capacity};
+
+		vk::DescriptorPoolCreateInfo poolCreateInfo{
+			.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+			.maxSets = 1,
+			.poolSizeCount = 1,
+			.pPoolSizes = &poolSize
+		};
+		descriptorPool = core->device().createDescriptorPool(poolCreateInfo, nullptr);
+
+		vk::DescriptorBindingFlags flags =
+				vk::DescriptorBindingFlagBits::ePartiallyBound |
+				vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+				vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+
+		vk::DescriptorBindingFlags bindingFlags[] { flags, flags };
+
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{
+			.bindingCount = std::size(bindingFlags),
+			.pBindingFlags = bindingFlags
+		};
+
+		vk::DescriptorSetLayoutBinding bindings[] {
+			{
+				.binding = Texture2D,
+				.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+				.descriptorCount = slots[Texture2D].capacity,
+				.stageFlags = vk::ShaderStageFlagBits::eFragment
+			},
+			{
+				.binding = Texture2DArray,
+				.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+				.descriptorCount = slots[Texture2DArray].capacity,
+				.stageFlags = vk::ShaderStageFlagBits::eFragment
+			}
+		};
+
+		vk::DescriptorSetLayoutCreateInfo layoutCreateInfo{
+			.pNext = &bindingFlagsCreateInfo,
+			.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+			.bindingCount = std::size(bindings),
+			.pBindings = bindings
+		};
+		descriptorSetLayout = core->device().createDescriptorSetLayout(layoutCreateInfo, nullptr);
+
+		vk::DescriptorSetAllocateInfo allocateInfo{
+			.descriptorPool = descriptorPool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &descriptorSetLayout
+		};
+		core->device().allocateDescriptorSets(&allocateInfo, &descriptorSet);
+	}
+
+	// the device is idle by now, so everything still waiting for its frames can go
+	void destroy() {
+		auto core = RenderSystem::Instance();
+
+		for (auto& entry : retired) {
+			_destroy(entry);
+		}
+		retired.clear();
+
+		core->device().destroyDescriptorPool(descriptorPool, nullptr);
+		core->device().destroyDescriptorSetLayout(descriptorSetLayout, nullptr);
+		core->device().destroySampler(sampler, nullptr);
+	}
+
+	// writes the view into a free slot and returns its index. a full array is an error, there is no slot
+	// a draw could fall back to
+	uint32_t add(vk::ImageView view, Binding binding = Texture2D) {
+		std::lock_guard lock(mutex);
+
+		auto& slot = slots[binding];
+
+		uint32_t index;
+		if (!slot.freeIndices.empty()) {
+			index = slot.freeIndices.back();
+			slot.freeIndices.pop_back();
+		} else if (slot.nextIndex < slot.capacity) {
+			index = slot.nextIndex++;
+		} else {
+			throw std::runtime_error(fmt::format("bindless texture array {} is full ({} slots)", uint32_t(binding), slot.capacity));
+		}
+
+		vk::DescriptorImageInfo imageInfo{
+			.sampler = sampler,
+			.imageView = view,
+			.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+		};
+
+		vk::WriteDescriptorSet writeDescriptorSet{
+			.dstSet = descriptorSet,
+			.dstBinding = binding,
+			.dstArrayElement = index,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+			.pImageInfo = &imageInfo
+		};
+		RenderSystem::Instance()->device().updateDescriptorSets(1, &writeDescriptorSet, 0, nullptr);
+		return index;
+	}
+
+	// frames still in flight may sample the texture through its slot, so the slot is only reused and the view and
+	// image are only destroyed once they have completed. textures without a slot pass InvalidIndex
+	void retire(uint32_t index, Binding binding, vk::ImageView view, vk::Image image, VmaAllocation allocation, uint64_t frame) {
+		std::lock_guard lock(mutex);
+		retired.emplace_back(Retired{frame, binding, index, view, image, allocation});
+	}
+
+	void collect(uint64_t frame, uint32_t framesInFlight) {
+		std::lock_guard lock(mutex);
+
+		std::erase_if(retired, [&](const Retired& entry) {
+			if (entry.frame + framesInFlight > frame) {
+				return false;
+			}
+			_destroy(entry);
+			if (entry.index != InvalidIndex) {
+				slots[entry.binding].freeIndices.push_back(entry.index);
+			}
+			return true;
+		});
+	}
+
+private:
+	struct Slots {
+		uint32_t capacity = 0;
+		uint32_t nextIndex = 0;
+		std::vector<uint32_t> freeIndices;
+	};
+
+	struct Retired {
+		uint64_t frame;
+		Binding binding;
+		uint32_t index;
+		vk::ImageView view;
+		vk::Image image;
+		VmaAllocation allocation;
+	};
+
+	static void _destroy(const Retired& entry) {
+		auto core = RenderSystem::Instance();
+
+		core->device().destroyImageView(entry.view, nullptr);
+		vmaDestroyImage(core->allocator(), entry.image, entry.allocation);
+	}
+
+	std::mutex mutex;
+
+	Slots slots[2];
+	std::vector<Retired> retired;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "RenderSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// scales the scene's render area so that the gpu frame time settles on a target.
+// frame time is assumed to grow with the pixel count, so the scale moves by the square root of the error
+struct DynamicResolution {
+	inline static constexpr float MinScale = 0.5f;
+	inline static constexpr float MaxScale = 1.0f;
+	// the scale stays on a grid so that noise in the timings doesn't change the render area every frame
+	inline static constexpr float Step = 1.0f / 64.0f;
+	// inside this fraction of the target the scale is left alone, otherwise it would hunt around it
+	inline static constexpr double Tolerance = 0.05;
+	// only part of the error is corrected at once, the estimate is rough
+	inline static constexpr float Damping = 0.5f;
+	// gpu timings lag a few frames behind, after a change the scale holds until they reflect it
+	inline static constexpr uint32_t SettleFrames = 8;
+
+	bool enabled = false;
+	double targetFrameTime = 1000.0 / 60.0;
+	float scale = MaxScale;
+
+	void update(double gpuFrameTime) {
+		if (!enabled) {
+			scale = MaxScale;
+			smoothedFrameTime = 0.0;
+			settleFrames = 0;
+			return;
+		}
+		if (gpuFrameTime <= 0.0) {
+			return;
+		}
+		if (settleFrames != 0) {
+			settleFrames--;
+			return;
+		}
+
+		smoothedFrameTime = smoothedFrameTime == 0.0 ? gpuFrameTime : smoothedFrameTime * 0.8 + gpuFrameTime * 0.2;
+
+		const auto ratio = targetFrameTime / smoothedFrameTime;
+		if (std::abs(ratio - 1.0) < Tolerance) {
+			return;
+		}
+
+		const auto desired = std::clamp(scale * float(std::sqrt(ratio)), MinScale, MaxScale);
+		auto next = std::round((scale + (desired - scale) * Damping) / Step) * Step;
+
+		// a damped step smaller than the grid still moves by one step, or the scale would stall short of the target
+		if (next == scale && desired != scale) {
+			next = desired > scale ? std::min(scale + Step, desired) : std::max(scale - Step, desired);
+		}
+		next = std::clamp(next, MinScale, MaxScale);
+		if (next != scale) {
+			scale = next;
+			smoothedFrameTime = 0.0;
+			settleFrames = SettleFrames;
+		}
+	}
+
+	vk::Extent2D apply(vk::Extent2D extent) const {
+		return {
+			std::max(uint32_t(float(extent.width) * scale), 1u),
+			std::max(uint32_t(float(extent.height) * scale), 1u)
+		};
+	}
+
+private:
+	double smoothedFrameTime = 0.0;
+	uint32_t settleFrames = 0;
+};
@@ -3,20 +3,32 @@
 #include "VertexBuilder.hpp"
 
 #include "client/renderer/RenderBuffer.hpp"
+#include "client/renderer/RenderContext.hpp"
+#include "client/renderer/RenderQueue.hpp"
 #include "client/renderer/model/ModelFormat.hpp"
 #include "client/renderer/material/Material.hpp"
 #include "client/renderer/TexturedQuad.hpp"
+#include "client/renderer/culling/GpuCuller.hpp"
+
+#include "util/math/AABB.hpp"
+
+#include <algorithm>
+#include <span>
 
 #include "client/util/Handle.hpp"
 
 struct EntityRenderer {
 	Handle<Material> material;
 
-	EntityRenderer(Handle<Material> material, Handle<ModelFormat> model_format) : material(material) {
+	// model space bounds of every rendered cube, used for culling
+	AABB bounds{};
+
+	EntityRenderer(Handle<RenderContext> renderContext, Handle<Material> material, Handle<ModelFormat> model_format) : material(material) {
 		auto texture_width = model_format->texture_width;
 		auto texture_height = model_format->texture_height;
 
 		VertexBuilder builder;
+		bool hasBounds = false;
 		for (auto& [name, bone] : model_format->bones) {
 			if (bone->neverRender) continue;
 
@@ -36,6 +48,16 @@ struct EntityRenderer {
 				auto y1 = y0 + size.y / 16.0f;
 				auto z1 = z0 + size.z / 16.0f;
 
+				if (!hasBounds) {
+					bounds.set(x0, y0, z0, x1, y1, z1);
+					hasBounds = true;
+				} else {
+					bounds.set(
+						std::min(bounds.minX, x0), std::min(bounds.minY, y0), std::min(bounds.minZ, z0),
+						std::max(bounds.maxX, x1), std::max(bounds.maxY, y1), std::max(bounds.maxZ, z1)
+					);
+				}
+
 				if (cube.uv_box) {
 					auto u = uv.x;
 					auto v = uv.y;
@@ -222,11 +244,11 @@ struct EntityRenderer {
 			}
 		}
 
-		renderBuffer.SetIndexBufferCount(builder.indices.size(), sizeof(int));
-		renderBuffer.SetVertexBufferCount(builder.vertices.size(), sizeof(Vertex));
+		renderBuffer.SetIndexBufferCount(builder.indices.size(), sizeof(int), VMA_MEMORY_USAGE_GPU_ONLY);
+		renderBuffer.SetVertexBufferCount(builder.vertices.size(), sizeof(Vertex), VMA_MEMORY_USAGE_GPU_ONLY);
 
-		renderBuffer.SetIndexBufferData(builder.indices.data(), 0, 0, sizeof(int) * builder.indices.size());
-		renderBuffer.SetVertexBufferData(builder.vertices.data(), 0, 0, sizeof(Vertex) * builder.vertices.size());
+		renderContext->bufferSubData(renderBuffer.IndexBuffer, 0, renderBuffer.IndexBufferSize, builder.indices.data());
+		renderContext->bufferSubData(renderBuffer.VertexBuffer, 0, renderBuffer.VertexBufferSize, builder.vertices.data());
 	}
 
 	void buildFace(
@@ -262,7 +284,91 @@ struct EntityRenderer {
 		renderBuffer.destroy();
 	}
 
-	void render(vk::CommandBuffer cmd, CameraTransform& transform) {
+	// overrides the material's texture, so renderers sharing a material can still draw different textures
+	void setTexture(Texture* texture) {
+		textureOverride = texture->renderTexture->bindlessIndex;
+	}
+
+	// depth is the distance used to order the draw within its layer
+	void submit(RenderQueue& queue, const CameraTransform& transform, float depth) {
+		_submit(queue, transform, depth, textureIndex());
+	}
+
+	// every instance shares this renderer's geometry and material, texture and tint come from the instance data.
+	// falls back to one draw per instance when the material has no instanced pipeline, those draws keep the
+	// instance's texture but drop its tint, the non-instanced shaders have no input for it
+	void submitInstances(RenderQueue& queue, InstanceBuffer& instanceBuffer, uint32_t frameIndex, const CameraTransform& transform, std::span<const InstanceData> instances, float depth) {
+		if (instances.empty()) {
+			return;
+		}
+
+		if (!material->instancedPipeline) {
+			for (auto& instance : instances) {
+				_submit(queue, CameraTransform{.camera = transform.camera * instance.model}, depth, instance.textureIndex);
+			}
+			return;
+		}
+
+		queue.submit(DrawPacket{
+			.layer = material->layer,
+			.pipeline = material->instancedPipeline,
+			.pipelineLayout = material->instancedPipelineLayout,
+			.descriptorSet = material->descriptorSet,
+			.instanceSet = instanceBuffer.descriptorSet(frameIndex),
+			.depth = depth,
+			.vertexBuffer = renderBuffer.VertexBuffer,
+			.indexBuffer = renderBuffer.IndexBuffer,
+			.indexCount = uint32_t(renderBuffer.IndexCount),
+			.firstIndex = 0,
+			.vertexOffset = 0,
+			.instanceCount = uint32_t(instances.size()),
+			.firstInstance = instanceBuffer.push(instances),
+			.transform = transform,
+			.textureConstants = {
+				.textureIndex = textureIndex()
+			}
+		});
+	}
+
+	// bindless index of the texture drawn with, the override or the material's default
+	uint32_t textureIndex() const {
+		return textureOverride != BindlessTextures::InvalidIndex ? textureOverride : material->textureIndex;
+	}
+
+	// draws whatever survived the gpu culling pass, the culler's commands index this renderer's buffers
+	void renderIndirect(vk::CommandBuffer cmd, CameraTransform& transform, GpuCuller& culler) {
+		_bind(cmd, transform);
+		culler.draw(cmd);
+	}
+
+	uint32_t indexCount() const {
+		return uint32_t(renderBuffer.IndexCount);
+	}
+
+private:
+	void _submit(RenderQueue& queue, const CameraTransform& transform, float depth, uint32_t texture) {
+		queue.submit(DrawPacket{
+			.layer = material->layer,
+			.pipeline = material->pipeline,
+			.pipelineLayout = material->pipelineLayout,
+			.descriptorSet = material->descriptorSet,
+			.instanceSet = nullptr,
+			.depth = depth,
+			.vertexBuffer = renderBuffer.VertexBuffer,
+			.indexBuffer = renderBuffer.IndexBuffer,
+			.indexCount = uint32_t(renderBuffer.IndexCount),
+			.firstIndex = 0,
+			.vertexOffset = 0,
+			.instanceCount = 1,
+			.firstInstance = 0,
+			.transform = transform,
+			.textureConstants = {
+				.textureIndex = texture
+			}
+		});
+	}
+
+	void _bind(vk::CommandBuffer cmd, CameraTransform& transform) {
 		vk::DeviceSize offset{0};
 
 		vk::Buffer vertexBuffers[] {
@@ -273,12 +379,15 @@ struct EntityRenderer {
 		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, material->pipelineLayout, 0, 1, &material->descriptorSet, 0, nullptr);
 		cmd.pushConstants(material->pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(CameraTransform), &transform);
 
+		TextureConstants textureConstants{
+			.textureIndex = textureIndex()
+		};
+		cmd.pushConstants(material->pipelineLayout, vk::ShaderStageFlagBits::eFragment, sizeof(CameraTransform), sizeof(TextureConstants), &textureConstants);
+
 		cmd.bindVertexBuffers(0, 1, vertexBuffers, &offset);
 		cmd.bindIndexBuffer(renderBuffer.IndexBuffer, 0, vk::IndexType::eUint32);
-
-		cmd.drawIndexed(renderBuffer.IndexCount, 1, 0, 0, 0);
 	}
 
-private:
 	RenderBuffer renderBuffer;
+	uint32_t textureOverride{BindlessTextures::InvalidIndex};
 };
@@ -0,0 +1,190 @@
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace {
+	constexpr auto StatisticsFlags =
+			vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+			vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+			vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+			vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+			vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+}
+
+void GpuProfiler::create(uint32_t count) {
+	auto core = RenderSystem::Instance();
+	auto properties = core->physicalDevice().getProperties();
+	auto queueFamilies = core->physicalDevice().getQueueFamilyProperties();
+
+	timestampPeriod = properties.limits.timestampPeriod;
+	timestampsSupported = queueFamilies[core->graphicsFamily()].timestampValidBits != 0;
+	statisticsSupported = core->pipelineStatisticsSupported();
+
+	frameIndex = 0;
+	frameCount = count;
+	frames = std::make_unique<FrameQueries[]>(frameCount);
+
+	if (timestampsSupported) {
+		timestampPool = core->device().createQueryPool({
+				.queryType = vk::QueryType::eTimestamp,
+				.queryCount = frameCount * MaxScopes * 2
+		});
+	}
+
+	if (statisticsSupported) {
+		statisticsPool = core->device().createQueryPool({
+				.queryType = vk::QueryType::ePipelineStatistics,
+				.queryCount = frameCount * MaxScopes,
+				.pipelineStatistics = StatisticsFlags
+		});
+	}
+}
+
+void GpuProfiler::destroy() {
+	auto core = RenderSystem::Instance();
+
+	if (timestampPool) {
+		core->device().destroyQueryPool(timestampPool, nullptr);
+		timestampPool = nullptr;
+	}
+	if (statisticsPool) {
+		core->device().destroyQueryPool(statisticsPool, nullptr);
+		statisticsPool = nullptr;
+	}
+	frames.reset();
+}
+
+void GpuProfiler::beginFrame(vk::CommandBuffer cmd, uint32_t index) {
+	frameIndex = index;
+
+	_collect(frameIndex);
+
+	auto& queries = frames[frameIndex];
+	queries.frame = frameNumber++;
+	queries.used = 0;
+
+	if (timestampsSupported) {
+		cmd.resetQueryPool(timestampPool, frameIndex * MaxScopes * 2, MaxScopes * 2);
+	}
+	if (statisticsSupported) {
+		cmd.resetQueryPool(statisticsPool, frameIndex * MaxScopes, MaxScopes);
+	}
+}
+
+uint32_t GpuProfiler::beginScope(vk::CommandBuffer cmd, std::string_view name, bool statistics) {
+	if (!timestampsSupported) {
+		return InvalidScope;
+	}
+
+	auto& queries = frames[frameIndex];
+
+	auto scope = queries.used++;
+	if (scope >= MaxScopes) {
+		return InvalidScope;
+	}
+
+	queries.names[scope] = name;
+	queries.statistics[scope] = statistics && statisticsSupported;
+
+	cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, timestampPool, (frameIndex * MaxScopes + scope) * 2);
+	if (queries.statistics[scope]) {
+		cmd.beginQuery(statisticsPool, frameIndex * MaxScopes + scope, {});
+	}
+	return scope;
+}
+
+void GpuProfiler::endScope(vk::CommandBuffer cmd, uint32_t scope) {
+	if (scope == InvalidScope) {
+		return;
+	}
+
+	if (frames[frameIndex].statistics[scope]) {
+		cmd.endQuery(statisticsPool, frameIndex * MaxScopes + scope);
+	}
+	cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timestampPool, (frameIndex * MaxScopes + scope) * 2 + 1);
+}
+
+void GpuProfiler::_collect(uint32_t index) {
+	auto& queries = frames[index];
+
+	auto count = std::min(queries.used.load(), MaxScopes);
+	if (count == 0) {
+		return;
+	}
+
+	auto device = RenderSystem::Instance()->device();
+
+	// the fence of this slot has signaled, so the results are available without waiting
+	uint64_t timestamps[MaxScopes * 2];
+	auto result = device.getQueryPoolResults(timestampPool, index * MaxScopes * 2, count * 2, sizeof(uint64_t) * count * 2, timestamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+	if (result != vk::Result::eSuccess) {
+		return;
+	}
+
+	GpuFrameResult frame{.frame = queries.frame};
+	frame.scopes.reserve(count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		PipelineStatistics statistics{};
+		if (queries.statistics[i]) {
+			device.getQueryPoolResults(statisticsPool, index * MaxScopes + i, 1, sizeof(statistics), &statistics, sizeof(statistics), vk::QueryResultFlagBits::e64);
+		}
+
+		frame.scopes.emplace_back(GpuScopeResult{
+				.name = queries.names[i],
+				.time = double(timestamps[i * 2 + 1] - timestamps[i * 2]) * timestampPeriod * 1e-6,
+				.statistics = statistics
+		});
+	}
+
+	frameTime = frame.scopes.front().time;
+
+	_pushHistory(frame);
+	if (recording) {
+		recorded.emplace_back(frame);
+	}
+	latest = std::move(frame);
+}
+
+void GpuProfiler::_pushHistory(const GpuFrameResult& result) {
+	for (auto& history : scopeHistory) {
+		history.times[historyCursor] = 0.0f;
+	}
+
+	for (auto& scope : result.scopes) {
+		auto it = std::find_if(scopeHistory.begin(), scopeHistory.end(), [&scope](const GpuScopeHistory& history) {
+			return history.name == scope.name;
+		});
+
+		if (it == scopeHistory.end()) {
+			it = scopeHistory.insert(scopeHistory.end(), GpuScopeHistory{
+					.name = scope.name,
+					.times = std::vector<float>(HistorySize, 0.0f)
+			});
+		}
+		it->times[historyCursor] += float(scope.time);
+	}
+
+	historyCursor = (historyCursor + 1) % HistorySize;
+}
+
+bool GpuProfiler::writeCsv(const std::filesystem::path& path) const {
+	std::ofstream ofs(path);
+	if (!ofs) {
+		return false;
+	}
+
+	ofs << "frame,scope,gpu_ms,ia_vertices,ia_primitives,vs_invocations,clipping_primitives,fs_invocations\n";
+	for (auto& frame : recorded) {
+		for (auto& scope : frame.scopes) {
+			ofs << frame.frame << ',' << scope.name << ',' << scope.time << ','
+				<< scope.statistics.inputAssemblyVertices << ','
+				<< scope.statistics.inputAssemblyPrimitives << ','
+				<< scope.statistics.vertexShaderInvocations << ','
+				<< scope.statistics.clippingPrimitives << ','
+				<< scope.statistics.fragmentShaderInvocations << '\n';
+		}
+	}
+	return bool(ofs);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "RenderSystem.hpp"
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct PipelineStatistics {
+	uint64_t inputAssemblyVertices;
+	uint64_t inputAssemblyPrimitives;
+	uint64_t vertexShaderInvocations;
+	uint64_t clippingPrimitives;
+	uint64_t fragmentShaderInvocations;
+};
+
+struct GpuScopeResult {
+	std::string_view name;
+	double time;
+	PipelineStatistics statistics;
+};
+
+struct GpuFrameResult {
+	uint64_t frame;
+	std::vector<GpuScopeResult> scopes;
+};
+
+struct GpuScopeHistory {
+	std::string_view name;
+	std::vector<float> times;
+};
+
+// timestamp and pipeline statistics queries per frame in flight, results are read back once the
+// frame's fence has signaled so the cpu never waits on them
+struct GpuProfiler {
+	inline static constexpr uint32_t MaxScopes = 64;
+	inline static constexpr size_t HistorySize = 240;
+	inline static constexpr uint32_t InvalidScope = ~0u;
+
+	void create(uint32_t frameCount);
+	void destroy();
+
+	// collects the results previously recorded into this frame slot and resets its queries, must be called outside a render pass
+	void beginFrame(vk::CommandBuffer cmd, uint32_t frameIndex);
+
+	// names must outlive the profiler, statistics are only collected for scopes recorded inside a single command buffer
+	uint32_t beginScope(vk::CommandBuffer cmd, std::string_view name, bool statistics = false);
+	void endScope(vk::CommandBuffer cmd, uint32_t scope);
+
+	// keeps every collected frame in addition to the rolling history, used to export whole benchmark runs
+	void setRecording(bool enabled) {
+		recording = enabled;
+	}
+
+	bool writeCsv(const std::filesystem::path& path) const;
+
+	const std::vector<GpuScopeHistory>& history() const {
+		return scopeHistory;
+	}
+
+	size_t historyOffset() const {
+		return historyCursor;
+	}
+
+	// gpu time in milliseconds of the first scope of the most recently collected frame
+	double frameTime = 0.0;
+
+	GpuFrameResult latest;
+
+private:
+	struct FrameQueries {
+		uint64_t frame = 0;
+		std::atomic_uint32_t used{0};
+		std::array<std::string_view, MaxScopes> names;
+		std::array<bool, MaxScopes> statistics;
+	};
+
+	void _collect(uint32_t frameIndex);
+	void _pushHistory(const GpuFrameResult& result);
+
+	bool timestampsSupported = false;
+	bool statisticsSupported = false;
+	float timestampPeriod = 1.0f;
+
+	vk::QueryPool timestampPool;
+	vk::QueryPool statisticsPool;
+
+	uint32_t frameIndex = 0;
+	uint32_t frameCount = 0;
+	uint64_t frameNumber = 0;
+	std::unique_ptr<FrameQueries[]> frames;
+
+	std::vector<GpuScopeHistory> scopeHistory;
+	size_t historyCursor = 0;
+
+	bool recording = false;
+	std::vector<GpuFrameResult> recorded;
+};
+
+// records a named scope for the lifetime of the object
+struct GpuProfileScope {
+	GpuProfileScope(GpuProfiler& profiler, vk::CommandBuffer cmd, std::string_view name, bool statistics = false)
+		: profiler(profiler), cmd(cmd), scope(profiler.beginScope(cmd, name, statistics)) {}
+
+	~GpuProfileScope() {
+		profiler.endScope(cmd, scope);
+	}
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+	GpuProfiler& profiler;
+	vk::CommandBuffer cmd;
+	uint32_t scope;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "RenderSystem.hpp"
+
+#include "client/util/Buffer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// matches the std430 layout of the instance buffer in entity_instanced.vert
+struct InstanceData {
+	glm::mat4 model;
+	glm::vec4 tint;
+	uint32_t textureIndex;
+	uint32_t padding[3];
+};
+
+// per-frame ring of instance data read by instanced draws through set 1.
+// instances are collected on the cpu while the frame is built and copied once its slot is free again
+struct InstanceBuffer {
+	inline static constexpr uint32_t MinCapacity = 1024;
+
+	vk::DescriptorPool descriptorPool;
+	vk::DescriptorSetLayout descriptorSetLayout;
+
+	void create(uint32_t frameCount) {
+		auto core = RenderSystem::Instance();
+
+		vk::DescriptorPoolSize poolSize{vk::DescriptorType::eStorageBuffer, frameCount};
+
+		vk::DescriptorPoolCreateInfo poolCreateInfo{
+			.maxSets = frameCount,
+			.poolSizeCount = 1,
+			.pPoolSizes = &poolSize
+		};
+		descriptorPool = core->device().createDescriptorPool(poolCreateInfo, nullptr);
+
+		vk::DescriptorSetLayoutBinding binding{
+			.binding = 0,
+			.descriptorType = vk::DescriptorType::eStorageBuffer,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eVertex
+		};
+
+		vk::DescriptorSetLayoutCreateInfo layoutCreateInfo{
+			.bindingCount = 1,
+			.pBindings = &binding
+		};
+		descriptorSetLayout = core->device().createDescriptorSetLayout(layoutCreateInfo, nullptr);
+
+		frames.resize(frameCount);
+		for (auto& frame : frames) {
+			vk::DescriptorSetAllocateInfo allocateInfo{
+				.descriptorPool = descriptorPool,
+				.descriptorSetCount = 1,
+				.pSetLayouts = &descriptorSetLayout
+			};
+			core->device().allocateDescriptorSets(&allocateInfo, &frame.descriptorSet);
+
+			_reserve(frame, MinCapacity);
+		}
+	}
+
+	void destroy() {
+		auto core = RenderSystem::Instance();
+
+		for (auto& frame : frames) {
+			frame.buffer.unmap();
+			frame.buffer.destroy();
+		}
+		frames.clear();
+
+		core->device().destroyDescriptorPool(descriptorPool, nullptr);
+		core->device().destroyDescriptorSetLayout(descriptorSetLayout, nullptr);
+	}
+
+	// returns the first instance index of the copied range, draws pass it as firstInstance
+	uint32_t push(std::span<const InstanceData> instances) {
+		auto first = uint32_t(pending.size());
+		pending.insert(pending.end(), instances.begin(), instances.end());
+		return first;
+	}
+
+	vk::DescriptorSet descriptorSet(uint32_t frameIndex) const {
+		return frames[frameIndex].descriptorSet;
+	}
+
+	// called once the frame's fence has been waited on, nothing reads the slot anymore
+	void upload(uint32_t frameIndex) {
+		auto& frame = frames[frameIndex];
+
+		if (pending.size() > frame.capacity) {
+			_reserve(frame, std::bit_ceil(uint32_t(pending.size())));
+		}
+
+		if (!pending.empty()) {
+			std::memcpy(frame.data, pending.data(), sizeof(InstanceData) * pending.size());
+			frame.buffer.flush(0, sizeof(InstanceData) * pending.size());
+		}
+		pending.clear();
+	}
+
+private:
+	struct Frame {
+		Buffer buffer;
+		void* data{nullptr};
+		uint32_t capacity{0};
+		vk::DescriptorSet descriptorSet;
+	};
+
+	// the descriptor set keeps its handle, queued draws reference the set rather than the buffer
+	void _reserve(Frame& frame, uint32_t capacity) {
+		if (frame.data != nullptr) {
+			frame.buffer.unmap();
+			frame.buffer.destroy();
+		}
+
+		frame.capacity = std::max(capacity, MinCapacity);
+		frame.buffer = Buffer::create(
+			{.size = sizeof(InstanceData) * frame.capacity, .usage = vk::BufferUsageFlagBits::eStorageBuffer},
+			{.usage = VMA_MEMORY_USAGE_CPU_TO_GPU}
+		);
+		frame.data = frame.buffer.map();
+
+		vk::DescriptorBufferInfo bufferInfo{
+			.buffer = frame.buffer,
+			.offset = 0,
+			.range = VK_WHOLE_SIZE
+		};
+
+		vk::WriteDescriptorSet writeDescriptorSet{
+			.dstSet = frame.descriptorSet,
+			.dstBinding = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eStorageBuffer,
+			.pBufferInfo = &bufferInfo
+		};
+		RenderSystem::Instance()->device().updateDescriptorSets(1, &writeDescriptorSet, 0, nullptr);
+	}
+
+	std::vector<Frame> frames;
+	std::vector<InstanceData> pending;
+};
@@ -3,6 +3,8 @@
 #include "RenderSystem.hpp"
 #include "client/util/Buffer.hpp"
 
+#include <algorithm>
+
 struct RenderBuffer {
 	Buffer VertexBuffer{};
 	Buffer IndexBuffer{};
@@ -13,7 +15,14 @@ struct RenderBuffer {
 	vk::DeviceSize VertexBufferSize{0};
 	vk::DeviceSize IndexBufferSize{0};
 
-	void SetVertexBufferCount(int count, size_t elementSize) {
+	// grow-only streaming storage, mapped once and kept mapped until the buffer has to grow
+	void* VertexData{nullptr};
+	void* IndexData{nullptr};
+
+	vk::DeviceSize VertexBufferCapacity{0};
+	vk::DeviceSize IndexBufferCapacity{0};
+
+	void SetVertexBufferCount(int count, size_t elementSize, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY) {
 		VertexBuffer.destroy();
 
 		VertexCount = count;
@@ -21,9 +30,9 @@ struct RenderBuffer {
 		if (VertexBufferSize > 0) {
 			vk::BufferCreateInfo BufferCI {
 				.size = VertexBufferSize,
-				.usage = vk::BufferUsageFlagBits::eVertexBuffer
+				.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst
 			};
-			VertexBuffer = Buffer::create(BufferCI, {.usage = VMA_MEMORY_USAGE_CPU_ONLY});
+			VertexBuffer = Buffer::create(BufferCI, {.usage = memoryUsage});
 		}
 	}
 
@@ -33,7 +42,7 @@ struct RenderBuffer {
 		VertexBuffer.unmap();
 	}
 
-	void SetIndexBufferCount(int count, size_t elementSize) {
+	void SetIndexBufferCount(int count, size_t elementSize, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY) {
 		IndexBuffer.destroy();
 
 		IndexCount = count;
@@ -41,9 +50,9 @@ struct RenderBuffer {
 		if (IndexBufferSize > 0) {
 			vk::BufferCreateInfo BufferCI {
 				.size = IndexBufferSize,
-				.usage = vk::BufferUsageFlagBits::eIndexBuffer
+				.usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst
 			};
-			IndexBuffer = Buffer::create(BufferCI, {.usage = VMA_MEMORY_USAGE_CPU_ONLY});
+			IndexBuffer = Buffer::create(BufferCI, {.usage = memoryUsage});
 		}
 	}
 
@@ -53,8 +62,63 @@ struct RenderBuffer {
 		IndexBuffer.unmap();
 	}
 
+	void ReserveVertexBuffer(int count, size_t elementSize) {
+		VertexCount = count;
+		VertexBufferSize = count * elementSize;
+		_Reserve(VertexBuffer, VertexData, VertexBufferCapacity, VertexBufferSize, vk::BufferUsageFlagBits::eVertexBuffer);
+	}
+
+	void ReserveIndexBuffer(int count, size_t elementSize) {
+		IndexCount = count;
+		IndexBufferSize = count * elementSize;
+		_Reserve(IndexBuffer, IndexData, IndexBufferCapacity, IndexBufferSize, vk::BufferUsageFlagBits::eIndexBuffer);
+	}
+
+	void Flush() {
+		if (VertexData != nullptr) {
+			VertexBuffer.flush(0, VertexBufferSize);
+		}
+		if (IndexData != nullptr) {
+			IndexBuffer.flush(0, IndexBufferSize);
+		}
+	}
+
 	void destroy() {
+		if (VertexData != nullptr) {
+			VertexBuffer.unmap();
+			VertexData = nullptr;
+		}
+		if (IndexData != nullptr) {
+			IndexBuffer.unmap();
+			IndexData = nullptr;
+		}
 		VertexBuffer.destroy();
 		IndexBuffer.destroy();
+
+		VertexBufferCapacity = 0;
+		IndexBufferCapacity = 0;
+	}
+
+private:
+	inline static constexpr vk::DeviceSize MinStreamCapacity = 64 * 1024;
+
+	static void _Reserve(Buffer& buffer, void*& data, vk::DeviceSize& capacity, vk::DeviceSize size, vk::BufferUsageFlags usage) {
+		if (size <= capacity) {
+			return;
+		}
+
+		if (data != nullptr) {
+			buffer.unmap();
+			buffer.destroy();
+		}
+
+		capacity = std::max(std::max(capacity * 2, size), MinStreamCapacity);
+
+		vk::BufferCreateInfo BufferCI {
+			.size = capacity,
+			.usage = usage
+		};
+		buffer = Buffer::create(BufferCI, {.usage = VMA_MEMORY_USAGE_CPU_TO_GPU});
+		data = buffer.map();
 	}
 };
\ No newline at end of file
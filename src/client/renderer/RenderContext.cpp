@@ -2,7 +2,9 @@
 
 #include "client/util/Buffer.hpp"
 
-RenderContext::RenderContext() {
+#include "util/ThreadPool.hpp"
+
+RenderContext::RenderContext(vk::Extent2D offscreenExtent) {
 	vk::DescriptorPoolSize descriptorPoolSizes[] = {
 			{vk::DescriptorType::eSampler, 1000},
 			{vk::DescriptorType::eCombinedImageSampler, 1000},
@@ -18,31 +20,51 @@ RenderContext::RenderContext() {
 	};
 
 	descriptorPool = DescriptorPool::create(1000, descriptorPoolSizes);
+	bindlessTextures.create();
+	instanceBuffer.create(MaxFramesInFlight);
 	commandPool = CommandPool::create(core->graphicsFamily(), vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+	transferCommandPool = CommandPool::create(core->transferFamily(), vk::CommandPoolCreateFlagBits::eTransient);
 
-	_createSwapchain();
+	profiler.create(MaxFramesInFlight);
+
+	if (core->headless()) {
+		_createOffscreenImages(offscreenExtent);
+	} else {
+		_createSwapchain();
+	}
 	_createRenderPass();
-	_createSyncObjects();
+	_createOverlayRenderPass();
+	_createImageObjects();
 	_createFrameObjects();
+	_createUploadObjects();
 }
 
 RenderContext::~RenderContext() {
 	core->device().waitIdle();
 
-	for (uint32_t i = 0; i < frameCount; i++) {
-		core->device().destroyFramebuffer(framebuffers[i], nullptr);
-		core->device().destroyImageView(swapchainImageViews[i], nullptr);
-
-		commandPools[i].free(commandBuffers[i]);
-		commandPools[i].destroy();
+	_destroyFrameObjects();
+	_destroyImageObjects();
 
-		core->device().destroyFence(fences[i], nullptr);
-		core->device().destroySemaphore(imageAcquiredSemaphore[i], nullptr);
-		core->device().destroySemaphore(renderCompleteSemaphore[i], nullptr);
+	for (auto& upload : pendingUploads) {
+		transferCommandPool.free(upload.cmd);
+		upload.stagingBuffer.destroy();
 	}
+	pendingUploads.clear();
+
+	core->device().destroySemaphore(uploadSemaphore, nullptr);
+	transferCommandPool.destroy();
+
+	profiler.destroy();
+	instanceBuffer.destroy();
+	bindlessTextures.destroy();
 
 	core->device().destroyRenderPass(renderPass, nullptr);
-	core->device().destroySwapchainKHR(swapchain, nullptr);
+	core->device().destroyRenderPass(overlayRenderPass, nullptr);
+	if (core->headless()) {
+		_destroyOffscreenImages();
+	} else {
+		core->device().destroySwapchainKHR(swapchain, nullptr);
+	}
 	core->terminate();
 }
 
@@ -98,6 +120,20 @@ vk::SurfaceFormatKHR RenderContext::_selectSurfaceFormat(std::span<const vk::Sur
 	return surface_formats.front();
 }
 
+// the requested mode first, then the closest one that keeps its latency or tearing behaviour
+static std::vector<vk::PresentModeKHR> _presentModeFallbacks(vk::PresentModeKHR mode) {
+	switch (mode) {
+	case vk::PresentModeKHR::eMailbox:
+		return {vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eFifo};
+	case vk::PresentModeKHR::eImmediate:
+		return {vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo};
+	case vk::PresentModeKHR::eFifoRelaxed:
+		return {vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eFifo};
+	default:
+		return {vk::PresentModeKHR::eFifo};
+	}
+}
+
 vk::PresentModeKHR RenderContext::_selectPresentMode(std::span<const vk::PresentModeKHR> present_modes, std::span<const vk::PresentModeKHR> request_modes) {
 	for (size_t i = 0; i < request_modes.size(); i++)
 		for (size_t j = 0; j < present_modes.size(); j++)
@@ -118,11 +154,10 @@ void RenderContext::_createSwapchain() {
 			vk::Format::eR8G8B8Unorm
 	};
 
-	vk::PresentModeKHR request_modes [] {
-			vk::PresentModeKHR::eFifo
-	};
+	auto request_modes = _presentModeFallbacks(requestedPresentMode);
 
-	surfaceExtent = _selectSurfaceExtent({0, 0}, capabilities);
+	// sized for the native output, the scene only renders into a scaled part of it
+	surfaceExtent = _selectSurfaceExtent(outputExtent, capabilities);
 	surfaceFormat = _selectSurfaceFormat(surfaceFormats, request_formats, vk::ColorSpaceKHR::eSrgbNonlinear);
 	presentMode = _selectPresentMode(presentModes, request_modes);
 	int image_count = _getImageCountFromPresentMode(presentMode);
@@ -141,12 +176,12 @@ void RenderContext::_createSwapchain() {
 			.imageColorSpace = surfaceFormat.colorSpace,
 			.imageExtent = surfaceExtent,
 			.imageArrayLayers = 1,
-			.imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
+			.imageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst,
 			.preTransform = capabilities.currentTransform,
 			.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
 			.presentMode = presentMode,
 			.clipped = true,
-			.oldSwapchain = nullptr
+			.oldSwapchain = swapchain
 	};
 
 	uint32_t queue_family_indices[] = {
@@ -160,9 +195,73 @@ void RenderContext::_createSwapchain() {
 		swapchainCreateInfo.pQueueFamilyIndices = queue_family_indices;
 	}
 
+	auto oldSwapchain = swapchain;
 	swapchain = core->device().createSwapchainKHR(swapchainCreateInfo, nullptr);
+	if (oldSwapchain) {
+		core->device().destroySwapchainKHR(oldSwapchain, nullptr);
+	}
 	swapchainImages = core->device().getSwapchainImagesKHR(swapchain);
-	frameCount = swapchainImages.size();
+	imageCount = swapchainImages.size();
+	swapchainDirty = false;
+}
+
+// the render pass is kept, the surface format does not change between recreations
+void RenderContext::_recreateSwapchain() {
+	core->device().waitIdle();
+
+	_destroyImageObjects();
+	_createSwapchain();
+	_createImageObjects();
+
+	_updateRenderArea();
+}
+
+// outputExtent keeps the requested size, only the area drawn into is kept inside the surface sized targets
+void RenderContext::_updateRenderArea() {
+	auto extent = dynamicResolution.apply(outputExtent);
+	renderArea.extent.width = std::min(extent.width, surfaceExtent.width);
+	renderArea.extent.height = std::min(extent.height, surfaceExtent.height);
+}
+
+void RenderContext::_createOffscreenImages(vk::Extent2D extent) {
+	surfaceExtent = extent;
+	surfaceFormat = vk::SurfaceFormatKHR{
+			.format = vk::Format::eR8G8B8A8Unorm,
+			.colorSpace = vk::ColorSpaceKHR::eSrgbNonlinear
+	};
+
+	// one image per frame slot so that frames in flight never share a color target
+	imageCount = MaxFramesInFlight;
+	swapchainImages.resize(imageCount);
+	offscreenAllocations.resize(imageCount);
+
+	VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{
+		.imageType = vk::ImageType::e2D,
+		.format = surfaceFormat.format,
+		.extent = {
+			.width = extent.width,
+			.height = extent.height,
+			.depth = 1
+		},
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst
+	};
+
+	VmaAllocationCreateInfo allocationCreateInfo{.usage = VMA_MEMORY_USAGE_GPU_ONLY};
+	for (uint32_t i = 0; i < imageCount; i++) {
+		VkImage image;
+		vmaCreateImage(core->allocator(), &imageCreateInfo, &allocationCreateInfo, &image, &offscreenAllocations[i], nullptr);
+		swapchainImages[i] = image;
+	}
+}
+
+void RenderContext::_destroyOffscreenImages() {
+	for (uint32_t i = 0; i < imageCount; i++) {
+		vmaDestroyImage(core->allocator(), swapchainImages[i], offscreenAllocations[i]);
+	}
+	swapchainImages.clear();
+	offscreenAllocations.clear();
 }
 
 void RenderContext::_createRenderPass() {
@@ -178,7 +277,7 @@ void RenderContext::_createRenderPass() {
 					vk::AttachmentLoadOp::eDontCare,
 					vk::AttachmentStoreOp::eDontCare,
 					vk::ImageLayout::eUndefined,
-					vk::ImageLayout::ePresentSrcKHR
+					vk::ImageLayout::eTransferSrcOptimal
 			},
 			vk::AttachmentDescription{
 					{},
@@ -214,43 +313,107 @@ void RenderContext::_createRenderPass() {
 			nullptr
 	};
 
+	vk::SubpassDependency dependencies[]{
+			// both targets are shared by all frames in flight, so the previous frame's depth writes and upscale must finish first
+			{
+					VK_SUBPASS_EXTERNAL, 0,
+					vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+					vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
+					vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+					vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite
+			},
+			// the color target is read by the upscale blit
+			{
+					0, VK_SUBPASS_EXTERNAL,
+					vk::PipelineStageFlagBits::eColorAttachmentOutput,
+					vk::PipelineStageFlagBits::eTransfer,
+					vk::AccessFlagBits::eColorAttachmentWrite,
+					vk::AccessFlagBits::eTransferRead
+			}
+	};
+
+	vk::RenderPassCreateInfo render_pass_create_info{
+			.attachmentCount = 2,
+			.pAttachments = attachments,
+			.subpassCount = 1,
+			.pSubpasses = &subpass,
+			.dependencyCount = 2,
+			.pDependencies = dependencies,
+	};
+	renderPass = core->device().createRenderPass(render_pass_create_info, nullptr);
+}
+
+// keeps what the upscale wrote, so the gui draws over the scene at the resolution of the frame's image
+void RenderContext::_createOverlayRenderPass() {
+	vk::AttachmentDescription attachment{
+			{},
+			surfaceFormat.format,
+			vk::SampleCountFlagBits::e1,
+			vk::AttachmentLoadOp::eLoad,
+			vk::AttachmentStoreOp::eStore,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eTransferDstOptimal,
+			core->headless() ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR
+	};
+
+	vk::AttachmentReference color_attachment{
+			0, vk::ImageLayout::eColorAttachmentOptimal
+	};
+
+	vk::SubpassDescription subpass{
+			{},
+			vk::PipelineBindPoint::eGraphics,
+			0,
+			nullptr,
+			1,
+			&color_attachment,
+			nullptr,
+			nullptr,
+			0,
+			nullptr
+	};
+
 	vk::SubpassDependency dependency{
 			VK_SUBPASS_EXTERNAL, 0,
+			vk::PipelineStageFlagBits::eTransfer,
 			vk::PipelineStageFlagBits::eColorAttachmentOutput,
-			vk::PipelineStageFlagBits::eColorAttachmentOutput,
-			{},
-			vk::AccessFlagBits::eColorAttachmentWrite
+			vk::AccessFlagBits::eTransferWrite,
+			vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
 	};
 
 	vk::RenderPassCreateInfo render_pass_create_info{
-			.attachmentCount = 2,
-			.pAttachments = attachments,
+			.attachmentCount = 1,
+			.pAttachments = &attachment,
 			.subpassCount = 1,
 			.pSubpasses = &subpass,
 			.dependencyCount = 1,
 			.pDependencies = &dependency,
 	};
-	renderPass = core->device().createRenderPass(render_pass_create_info, nullptr);
+	overlayRenderPass = core->device().createRenderPass(render_pass_create_info, nullptr);
 }
 
-void RenderContext::_createSyncObjects() {
-	fences.resize(frameCount);
-	imageAcquiredSemaphore.resize(frameCount);
-	renderCompleteSemaphore.resize(frameCount);
+void RenderContext::_createImageObjects() {
+	swapchainImageViews.resize(imageCount);
+	renderCompleteSemaphore.resize(imageCount);
+	framebuffers.resize(imageCount);
 
-	for (uint32_t i = 0; i < frameCount; i++) {
-		fences[i] = core->device().createFence({.flags = vk::FenceCreateFlagBits::eSignaled});
-		imageAcquiredSemaphore[i] = core->device().createSemaphore({}, nullptr);
-		renderCompleteSemaphore[i] = core->device().createSemaphore({}, nullptr);
-	}
-}
+	// the scene targets are sized for the full surface, a scaled frame only draws into their top left corner
+	depthTexture = createDepthTexture(depthFormat, surfaceExtent.width, surfaceExtent.height);
+	sceneTexture = createColorTarget(surfaceFormat.format, surfaceExtent.width, surfaceExtent.height);
+	surfaceVersion++;
 
-void RenderContext::_createFrameObjects() {
-	commandPools.resize(frameCount);
-	commandBuffers.resize(frameCount);
-	framebuffers.resize(frameCount);
-	depthTextures.resize(frameCount);
-	swapchainImageViews.resize(frameCount);
+	vk::ImageView sceneAttachments[]{ sceneTexture->view, depthTexture->view };
+
+	vk::FramebufferCreateInfo scene_framebuffer_create_info{
+			.renderPass = renderPass,
+			.attachmentCount = 2,
+			.pAttachments = sceneAttachments,
+			.width = surfaceExtent.width,
+			.height = surfaceExtent.height,
+			.layers = 1
+	};
+	sceneFramebuffer = core->device().createFramebuffer(scene_framebuffer_create_info, nullptr);
 
 	vk::ImageViewCreateInfo swapchainImageViewCreateInfo{
 			.viewType = vk::ImageViewType::e2D,
@@ -260,39 +423,184 @@ void RenderContext::_createFrameObjects() {
 					0, 1, 0, 1
 			}
 	};
-	for (uint32_t i = 0; i < frameCount; i++) {
-		depthTextures[i] = createDepthTexture(depthFormat, surfaceExtent.width, surfaceExtent.height);
-
+	for (uint32_t i = 0; i < imageCount; i++) {
 		swapchainImageViewCreateInfo.image = swapchainImages[i];
 		swapchainImageViews[i] = core->device().createImageView(swapchainImageViewCreateInfo, nullptr);
 
-		vk::ImageView attachments[]{ swapchainImageViews[i], depthTextures[i]->view };
-
 		vk::FramebufferCreateInfo framebuffer_create_info{
-				.renderPass = renderPass,
-				.attachmentCount = 2,
-				.pAttachments = attachments,
+				.renderPass = overlayRenderPass,
+				.attachmentCount = 1,
+				.pAttachments = &swapchainImageViews[i],
 				.width = surfaceExtent.width,
 				.height = surfaceExtent.height,
 				.layers = 1
 		};
 
 		framebuffers[i] = core->device().createFramebuffer(framebuffer_create_info, nullptr);
+		renderCompleteSemaphore[i] = core->device().createSemaphore({}, nullptr);
+	}
+}
+
+void RenderContext::_createFrameObjects() {
+	fences.resize(frameCount);
+	imageAcquiredSemaphore.resize(frameCount);
+	commandPools.resize(frameCount);
+	commandBuffers.resize(frameCount);
+
+	for (uint32_t i = 0; i < frameCount; i++) {
+		fences[i] = core->device().createFence({.flags = vk::FenceCreateFlagBits::eSignaled});
+		imageAcquiredSemaphore[i] = core->device().createSemaphore({}, nullptr);
+
 		commandPools[i] = CommandPool::create(core->graphicsFamily(), vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
 		commandBuffers[i] = commandPools[i].allocate(vk::CommandBufferLevel::ePrimary);
 	}
+
+	threadCount = ThreadPool::Instance()->size() + 1;
+	secondaryCommandPools.resize(frameCount * threadCount);
+
+	for (auto& pool : secondaryCommandPools) {
+		pool.commandPool = CommandPool::create(core->graphicsFamily(), vk::CommandPoolCreateFlagBits::eTransient);
+	}
+
+	captureCallbacks.resize(frameCount);
+	captureBuffers.resize(frameCount);
+}
+
+void RenderContext::_destroyImageObjects() {
+	for (uint32_t i = 0; i < imageCount; i++) {
+		core->device().destroyFramebuffer(framebuffers[i], nullptr);
+		core->device().destroyImageView(swapchainImageViews[i], nullptr);
+		core->device().destroySemaphore(renderCompleteSemaphore[i], nullptr);
+	}
+
+	core->device().destroyFramebuffer(sceneFramebuffer, nullptr);
+	destroyTexture(sceneTexture);
+	sceneTexture = nullptr;
+	destroyTexture(depthTexture);
+	depthTexture = nullptr;
+}
+
+void RenderContext::_destroyFrameObjects() {
+	for (uint32_t i = 0; i < frameCount; i++) {
+		commandPools[i].free(commandBuffers[i]);
+		commandPools[i].destroy();
+
+		core->device().destroyFence(fences[i], nullptr);
+		core->device().destroySemaphore(imageAcquiredSemaphore[i], nullptr);
+	}
+
+	for (auto& pool : secondaryCommandPools) {
+		pool.commandPool.destroy();
+	}
+	secondaryCommandPools.clear();
+
+	// callers wait on the fences first, so every capture still owned by a slot is complete
+	for (uint32_t i = 0; i < frameCount; i++) {
+		_deliverCapture(i);
+		captureBuffers[i].destroy();
+	}
+	captureCallbacks.clear();
+	captureBuffers.clear();
+}
+
+// only recorded here, the frame objects are rebuilt once the current frame is submitted. frames read
+// frameIndex before begin() to queue draws against its slot, so it can't change in the middle of one
+void RenderContext::setFramesInFlight(uint32_t count) {
+	requestedFrameCount = std::clamp(count, 1u, MaxFramesInFlight);
+	framesDirty = true;
+}
+
+void RenderContext::setLatencyMode(LatencyMode mode) {
+	latencyMode = mode;
+	framesDirty = true;
+}
+
+void RenderContext::_applyFramesInFlight() {
+	framesDirty = false;
+
+	auto frame_count = latencyMode == LatencyMode::Low ? 1u : requestedFrameCount;
+	if (frame_count == frameCount) {
+		return;
+	}
+
+	core->device().waitForFences(uint32_t(fences.size()), fences.data(), true, std::numeric_limits<uint64_t>::max());
+
+	_destroyFrameObjects();
+	frameCount = frame_count;
+	frameIndex = 0;
+	_createFrameObjects();
+}
+
+void RenderContext::setPresentMode(vk::PresentModeKHR mode) {
+	if (mode == requestedPresentMode) {
+		return;
+	}
+	requestedPresentMode = mode;
+	swapchainDirty = !core->headless();
+}
+
+void RenderContext::_createUploadObjects() {
+	vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo {
+			.semaphoreType = vk::SemaphoreType::eTimeline,
+			.initialValue = 0
+	};
+
+	uploadSemaphore = core->device().createSemaphore({.pNext = &semaphoreTypeCreateInfo}, nullptr);
 }
 
 vk::CommandBuffer RenderContext::begin() {
 	static constinit auto timeout = std::numeric_limits<uint64_t>::max();
-	auto semaphore = imageAcquiredSemaphore[semaphoreIndex];
 
-	core->device().acquireNextImageKHR(swapchain, timeout, semaphore, nullptr, &frameIndex);
+	// wait until this frame slot is free before touching its semaphore and command buffer
 	core->device().waitForFences(1, &fences[frameIndex], true, timeout);
+
+	_deliverCapture(frameIndex);
+	bindlessTextures.collect(frameNumber, MaxFramesInFlight);
+	instanceBuffer.upload(frameIndex);
+
+	if (core->headless()) {
+		imageIndex = frameIndex;
+	} else {
+		if (swapchainDirty) {
+			_recreateSwapchain();
+		}
+
+		// an out of date swapchain can't be presented to at all, acquiring signals nothing so the semaphore can be reused.
+		// the fence is only reset once an image was acquired, otherwise the next wait on it would never return
+		auto result = core->device().acquireNextImageKHR(swapchain, timeout, imageAcquiredSemaphore[frameIndex], nullptr, &imageIndex);
+		while (result == vk::Result::eErrorOutOfDateKHR) {
+			_recreateSwapchain();
+			result = core->device().acquireNextImageKHR(swapchain, timeout, imageAcquiredSemaphore[frameIndex], nullptr, &imageIndex);
+		}
+		if (result == vk::Result::eSuboptimalKHR) {
+			swapchainDirty = true;
+		}
+	}
 	core->device().resetFences(1, &fences[frameIndex]);
 
+	for (uint32_t i = 0; i < threadCount; i++) {
+		auto& pool = secondaryCommandPools[frameIndex * threadCount + i];
+		pool.commandPool.reset();
+		pool.used = 0;
+	}
+
 	commandBuffers[frameIndex].begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
 
+	profiler.beginFrame(commandBuffers[frameIndex], frameIndex);
+	gpuFrameTime = profiler.frameTime;
+
+	dynamicResolution.update(gpuFrameTime);
+	_updateRenderArea();
+
+	frameScope = profiler.beginScope(commandBuffers[frameIndex], "frame");
+
+	_collectUploads();
+	_acquireUploads(commandBuffers[frameIndex]);
+
+	for (auto& record : beforeRenderPass) {
+		record(commandBuffers[frameIndex]);
+	}
+
 	vk::ClearValue clearColors[]{
 			vk::ClearColorValue(std::array{0, 0, 0, 1}),
 			vk::ClearDepthStencilValue{1.0f, 0}
@@ -300,53 +608,284 @@ vk::CommandBuffer RenderContext::begin() {
 
 	vk::RenderPassBeginInfo beginInfo {
 			.renderPass = renderPass,
-			.framebuffer = framebuffers[frameIndex],
+			.framebuffer = sceneFramebuffer,
 			.renderArea = renderArea,
 			.clearValueCount = 2,
 			.pClearValues = clearColors
 	};
 
-	commandBuffers[frameIndex].beginRenderPass(beginInfo, vk::SubpassContents::eInline);
+	commandBuffers[frameIndex].beginRenderPass(beginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+	activeRenderPass = renderPass;
+	activeFramebuffer = sceneFramebuffer;
 	return commandBuffers[frameIndex];
 }
 
+vk::CommandBuffer RenderContext::_allocateSecondary(size_t threadIndex) {
+	auto& pool = secondaryCommandPools[frameIndex * threadCount + threadIndex];
+	if (pool.used == pool.commandBuffers.size()) {
+		pool.commandBuffers.emplace_back(pool.commandPool.allocate(vk::CommandBufferLevel::eSecondary));
+	}
+	return pool.commandBuffers[pool.used++];
+}
+
+void RenderContext::execute(std::span<const DrawGroup> groups) {
+	std::vector<vk::CommandBuffer> secondaryCommandBuffers(groups.size());
+
+	vk::CommandBufferInheritanceInfo inheritanceInfo {
+			.renderPass = activeRenderPass,
+			.subpass = 0,
+			.framebuffer = activeFramebuffer
+	};
+
+	vk::CommandBufferBeginInfo beginInfo {
+			.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+			.pInheritanceInfo = &inheritanceInfo
+	};
+
+	auto workers = ThreadPool::Instance();
+	workers->parallel_for(groups.size(), [&](size_t i) {
+		auto cmd = _allocateSecondary(workers->threadIndex());
+		cmd.begin(beginInfo);
+		{
+			GpuProfileScope scope(profiler, cmd, groups[i].name, true);
+			groups[i].record(cmd);
+		}
+		cmd.end();
+
+		secondaryCommandBuffers[i] = cmd;
+	});
+
+	commandBuffers[frameIndex].executeCommands(uint32_t(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+}
+
+void RenderContext::beginOverlay() {
+	auto cmd = commandBuffers[frameIndex];
+	cmd.endRenderPass();
+
+	for (auto& record : afterRenderPass) {
+		record(cmd);
+	}
+
+	_upscale(cmd);
+
+	vk::RenderPassBeginInfo beginInfo {
+			.renderPass = overlayRenderPass,
+			.framebuffer = framebuffers[imageIndex],
+			.renderArea = {.offset = {0, 0}, .extent = surfaceExtent}
+	};
+
+	cmd.beginRenderPass(beginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+	activeRenderPass = overlayRenderPass;
+	activeFramebuffer = framebuffers[imageIndex];
+}
+
+// stretches the scaled render area over the whole image, at full scale this is a plain copy
+void RenderContext::_upscale(vk::CommandBuffer cmd) {
+	auto scope = profiler.beginScope(cmd, "upscale");
+
+	vk::ImageMemoryBarrier barrier{
+			.srcAccessMask = {},
+			.dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+			.oldLayout = vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eTransferDstOptimal,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = swapchainImages[imageIndex],
+			.subresourceRange {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.levelCount = 1,
+					.layerCount = 1
+			}
+	};
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	vk::ImageBlit region{
+			.srcSubresource {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.layerCount = 1
+			},
+			.srcOffsets = std::array{
+					vk::Offset3D{0, 0, 0},
+					vk::Offset3D{int32_t(renderArea.extent.width), int32_t(renderArea.extent.height), 1}
+			},
+			.dstSubresource {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.layerCount = 1
+			},
+			.dstOffsets = std::array{
+					vk::Offset3D{0, 0, 0},
+					vk::Offset3D{int32_t(surfaceExtent.width), int32_t(surfaceExtent.height), 1}
+			}
+	};
+	cmd.blitImage(sceneTexture->image, vk::ImageLayout::eTransferSrcOptimal, swapchainImages[imageIndex], vk::ImageLayout::eTransferDstOptimal, 1, &region, vk::Filter::eLinear);
+
+	profiler.endScope(cmd, scope);
+}
+
 void RenderContext::end() {
+	if (activeRenderPass != overlayRenderPass) {
+		beginOverlay();
+	}
 	commandBuffers[frameIndex].endRenderPass();
+	activeRenderPass = nullptr;
+	activeFramebuffer = nullptr;
+
+	profiler.endScope(commandBuffers[frameIndex], frameScope);
+
+	if (captureRequest && core->headless()) {
+		_recordCapture(commandBuffers[frameIndex]);
+	}
+
 	commandBuffers[frameIndex].end();
 
-	auto image_acquired_semaphore = imageAcquiredSemaphore[semaphoreIndex];
-	auto render_complete_semaphore = renderCompleteSemaphore[semaphoreIndex];
+	auto render_complete_semaphore = renderCompleteSemaphore[imageIndex];
+
+	vk::Semaphore wait_semaphores[] = {
+			imageAcquiredSemaphore[frameIndex],
+			uploadSemaphore
+	};
 
 	vk::PipelineStageFlags stages[] = {
-			vk::PipelineStageFlagBits::eColorAttachmentOutput
+			vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eFragmentShader
+	};
+
+	uint64_t wait_values[] = {
+			0,
+			uploadWaitValue
+	};
+
+	// offscreen frames have no image to acquire, the upload semaphore is only waited on
+	// when this frame acquired ownership of uploaded resources
+	const uint32_t wait_first = core->headless() ? 1 : 0;
+	const uint32_t wait_count = (uploadWaitValue != 0 ? 2 : 1) - wait_first;
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo {
+			.waitSemaphoreValueCount = wait_count,
+			.pWaitSemaphoreValues = wait_values + wait_first
 	};
 
 	vk::SubmitInfo submitInfo {
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &image_acquired_semaphore,
-			.pWaitDstStageMask = stages,
+			.pNext = &timelineSubmitInfo,
+			.waitSemaphoreCount = wait_count,
+			.pWaitSemaphores = wait_semaphores + wait_first,
+			.pWaitDstStageMask = stages + wait_first,
 			.commandBufferCount = 1,
 			.pCommandBuffers = &commandBuffers[frameIndex],
-			.signalSemaphoreCount = 1,
+			.signalSemaphoreCount = core->headless() ? 0u : 1u,
 			.pSignalSemaphores = &render_complete_semaphore
 	};
 
 	core->graphicsQueue().submit(1, &submitInfo, fences[frameIndex]);
+	uploadWaitValue = 0;
+	frameNumber += 1;
+
+	if (core->headless()) {
+		_nextFrame();
+		return;
+	}
 
 	vk::PresentInfoKHR presentInfo {
 			.waitSemaphoreCount = 1,
 			.pWaitSemaphores = &render_complete_semaphore,
 			.swapchainCount = 1,
 			.pSwapchains = &swapchain,
-			.pImageIndices = &frameIndex
+			.pImageIndices = &imageIndex
 	};
-	core->presentQueue().presentKHR(presentInfo);
+	auto result = core->presentQueue().presentKHR(&presentInfo);
+	if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR) {
+		swapchainDirty = true;
+	}
 //	core->presentQueue().waitIdle();
 
-	semaphoreIndex = (semaphoreIndex + 1) % frameCount;
+	_nextFrame();
+}
+
+// a pending frame count change is applied between frames, the next frame is built against the new slots
+// from its first read of frameIndex on
+void RenderContext::_nextFrame() {
+	frameIndex = (frameIndex + 1) % frameCount;
+
+	if (framesDirty) {
+		_applyFramesInFlight();
+	}
+}
+
+void RenderContext::requestCapture(CaptureCallback callback) {
+	captureRequest = std::move(callback);
+}
+
+void RenderContext::_recordCapture(vk::CommandBuffer cmd) {
+	auto& buffer = captureBuffers[frameIndex];
+	if (!buffer) {
+		vk::BufferCreateInfo bufferCI{
+				.size = vk::DeviceSize(surfaceExtent.width) * surfaceExtent.height * 4,
+				.usage = vk::BufferUsageFlagBits::eTransferDst
+		};
+		buffer = Buffer::create(bufferCI, {.usage = VMA_MEMORY_USAGE_GPU_TO_CPU});
+	}
+
+	vk::ImageMemoryBarrier copy_barrier{
+			.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+			.dstAccessMask = vk::AccessFlagBits::eTransferRead,
+			.oldLayout = vk::ImageLayout::eTransferSrcOptimal,
+			.newLayout = vk::ImageLayout::eTransferSrcOptimal,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = swapchainImages[imageIndex],
+			.subresourceRange {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.levelCount = 1,
+					.layerCount = 1
+			}
+	};
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer, {}, 0, nullptr, 0, nullptr, 1, &copy_barrier);
+
+	vk::BufferImageCopy region{
+			.imageSubresource {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.layerCount = 1
+			},
+			.imageExtent = {
+					.width = surfaceExtent.width,
+					.height = surfaceExtent.height,
+					.depth = 1
+			}
+	};
+
+	cmd.copyImageToBuffer(swapchainImages[imageIndex], vk::ImageLayout::eTransferSrcOptimal, buffer, 1, &region);
+
+	vk::BufferMemoryBarrier host_barrier{
+			.srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+			.dstAccessMask = vk::AccessFlagBits::eHostRead,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = buffer,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE
+	};
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, 0, nullptr, 1, &host_barrier, 0, nullptr);
+
+	captureCallbacks[frameIndex] = std::move(captureRequest);
+	captureRequest = nullptr;
 }
 
-RenderTexture* RenderContext::createTexture2D(vk::Format format, uint32_t width, uint32_t height) {
+void RenderContext::_deliverCapture(uint32_t index) {
+	if (!captureCallbacks[index]) {
+		return;
+	}
+
+	auto& buffer = captureBuffers[index];
+	buffer.invalidate();
+	captureCallbacks[index](surfaceExtent.width, surfaceExtent.height, buffer.map());
+	buffer.unmap();
+
+	captureCallbacks[index] = nullptr;
+}
+
+RenderTexture* RenderContext::createTexture2D(vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevels) {
 	 VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{
 		.imageType = vk::ImageType::e2D,
 		.format = format,
@@ -355,7 +894,7 @@ RenderTexture* RenderContext::createTexture2D(vk::Format format, uint32_t width,
 				.height = height,
 				.depth = 1
 		},
-		.mipLevels = 1,
+		.mipLevels = mipLevels,
 		.arrayLayers = 1,
 		.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
 	};
@@ -364,6 +903,77 @@ RenderTexture* RenderContext::createTexture2D(vk::Format format, uint32_t width,
 	VmaAllocationCreateInfo allocationCreateInfo{.usage = VMA_MEMORY_USAGE_GPU_ONLY};
 	vmaCreateImage(core->allocator(), &imageCreateInfo, &allocationCreateInfo, &texture->image, &texture->allocation, nullptr);
 
+	vk::ImageViewCreateInfo imageViewCreateInfo {
+		.image = texture->image,
+		.viewType = vk::ImageViewType::e2D,
+		.format = format,
+		.subresourceRange{
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.baseMipLevel = 0,
+			.levelCount = mipLevels,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		}
+	};
+	texture->view = core->device().createImageView(imageViewCreateInfo);
+	texture->bindlessIndex = bindlessTextures.add(texture->view);
+	return texture;
+}
+
+RenderTexture* RenderContext::createTexture2DArray(vk::Format format, uint32_t width, uint32_t height, uint32_t layers, uint32_t mipLevels) {
+	VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{
+		.imageType = vk::ImageType::e2D,
+		.format = format,
+		.extent = {
+				.width = width,
+				.height = height,
+				.depth = 1
+		},
+		.mipLevels = mipLevels,
+		.arrayLayers = layers,
+		.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
+	};
+
+	auto texture = new RenderTexture();
+	VmaAllocationCreateInfo allocationCreateInfo{.usage = VMA_MEMORY_USAGE_GPU_ONLY};
+	vmaCreateImage(core->allocator(), &imageCreateInfo, &allocationCreateInfo, &texture->image, &texture->allocation, nullptr);
+
+	vk::ImageViewCreateInfo imageViewCreateInfo {
+		.image = texture->image,
+		.viewType = vk::ImageViewType::e2DArray,
+		.format = format,
+		.subresourceRange{
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.baseMipLevel = 0,
+			.levelCount = mipLevels,
+			.baseArrayLayer = 0,
+			.layerCount = layers
+		}
+	};
+	texture->view = core->device().createImageView(imageViewCreateInfo);
+	texture->bindlessBinding = BindlessTextures::Texture2DArray;
+	texture->bindlessIndex = bindlessTextures.add(texture->view, BindlessTextures::Texture2DArray);
+	return texture;
+}
+
+RenderTexture* RenderContext::createColorTarget(vk::Format format, uint32_t width, uint32_t height) {
+	VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{
+		.imageType = vk::ImageType::e2D,
+		.format = format,
+		.extent = {
+			.width = width,
+			.height = height,
+			.depth = 1
+		},
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eSampled
+	};
+
+	auto texture = new RenderTexture();
+	VmaAllocationCreateInfo allocationCreateInfo{.usage = VMA_MEMORY_USAGE_GPU_ONLY};
+	vmaCreateImage(core->allocator(), &imageCreateInfo, &allocationCreateInfo, &texture->image, &texture->allocation, nullptr);
+
 	vk::ImageViewCreateInfo imageViewCreateInfo {
 		.image = texture->image,
 		.viewType = vk::ImageViewType::e2D,
@@ -376,6 +986,7 @@ RenderTexture* RenderContext::createTexture2D(vk::Format format, uint32_t width,
 			.layerCount = 1
 		}
 	};
+
 	texture->view = core->device().createImageView(imageViewCreateInfo);
 	return texture;
 }
@@ -391,7 +1002,7 @@ RenderTexture* RenderContext::createDepthTexture(vk::Format format, uint32_t wid
 		},
 		.mipLevels = 1,
 		.arrayLayers = 1,
-		.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment
+		.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled
 	};
 
 	auto texture = new RenderTexture();
@@ -415,34 +1026,85 @@ RenderTexture* RenderContext::createDepthTexture(vk::Format format, uint32_t wid
 	return texture;
 }
 
-void RenderContext::textureSubImage2D(RenderTexture* texture, uint32_t width, uint32_t height, int channels, const void *pixels) {
-	auto cmd = commandPool.allocate(vk::CommandBufferLevel::ePrimary);
-	cmd.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
-
-	vk::DeviceSize bufferSize = width * height * channels;
+// the view and image outlive the handle until the frames that may still sample them have completed
+void RenderContext::destroyTexture(RenderTexture* texture) {
+	bindlessTextures.retire(texture->bindlessIndex, texture->bindlessBinding, texture->view, texture->image, texture->allocation, frameNumber);
+	delete texture;
+}
 
-	vk::BufferCreateInfo srcBufferCI{.size = bufferSize, .usage = vk::BufferUsageFlagBits::eTransferSrc};
+Buffer RenderContext::_createStagingBuffer(vk::DeviceSize size, const void* data) {
+	vk::BufferCreateInfo srcBufferCI{.size = size, .usage = vk::BufferUsageFlagBits::eTransferSrc};
 
 	auto srcBuffer = Buffer::create(srcBufferCI, {.usage = VMA_MEMORY_USAGE_CPU_ONLY});
-	std::memcpy(srcBuffer.map(), pixels, bufferSize);
+	std::memcpy(srcBuffer.map(), data, size);
 	srcBuffer.unmap();
+	return srcBuffer;
+}
 
-	vk::ImageMemoryBarrier copy_barrier{
-			.dstAccessMask = vk::AccessFlagBits::eTransferWrite,
-			.oldLayout = vk::ImageLayout::eUndefined,
-			.newLayout = vk::ImageLayout::eTransferDstOptimal,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = texture->image,
-			.subresourceRange {
-					.aspectMask = vk::ImageAspectFlagBits::eColor,
-					.levelCount = 1,
-					.layerCount = 1
-			}
+void RenderContext::_submitUpload(vk::CommandBuffer cmd, Buffer stagingBuffer) {
+	cmd.end();
+
+	uploadValue += 1;
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo {
+			.signalSemaphoreValueCount = 1,
+			.pSignalSemaphoreValues = &uploadValue
 	};
 
-	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eHost, vk::PipelineStageFlagBits::eTransfer, {}, 0, nullptr, 0, nullptr, 1, &copy_barrier);
+	vk::SubmitInfo submitInfo{
+			.pNext = &timelineSubmitInfo,
+			.commandBufferCount = 1,
+			.pCommandBuffers = &cmd,
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &uploadSemaphore
+	};
+	core->transferQueue().submit(1, &submitInfo, nullptr);
 
+	pendingUploads.emplace_back(PendingUpload{
+			.value = uploadValue,
+			.cmd = cmd,
+			.stagingBuffer = stagingBuffer
+	});
+}
+
+void RenderContext::_collectUploads() {
+	if (pendingUploads.empty()) {
+		return;
+	}
+
+	auto completed = core->device().getSemaphoreCounterValue(uploadSemaphore);
+
+	std::erase_if(pendingUploads, [this, completed](PendingUpload& upload) {
+		if (upload.value > completed) {
+			return false;
+		}
+		transferCommandPool.free(upload.cmd);
+		upload.stagingBuffer.destroy();
+		return true;
+	});
+}
+
+void RenderContext::_acquireUploads(vk::CommandBuffer cmd) {
+	if (imageAcquireBarriers.empty() && bufferAcquireBarriers.empty()) {
+		return;
+	}
+
+	cmd.pipelineBarrier(
+			vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eFragmentShader,
+			vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eFragmentShader,
+			{},
+			0, nullptr,
+			uint32_t(bufferAcquireBarriers.size()), bufferAcquireBarriers.data(),
+			uint32_t(imageAcquireBarriers.size()), imageAcquireBarriers.data()
+	);
+
+	imageAcquireBarriers.clear();
+	bufferAcquireBarriers.clear();
+
+	uploadWaitValue = uploadValue;
+}
+
+void RenderContext::textureSubImage2D(RenderTexture* texture, uint32_t width, uint32_t height, int channels, const void *pixels) {
 	vk::BufferImageCopy region{
 			.imageSubresource {
 					.aspectMask = vk::ImageAspectFlagBits::eColor,
@@ -455,7 +1117,34 @@ void RenderContext::textureSubImage2D(RenderTexture* texture, uint32_t width, ui
 			}
 	};
 
-	cmd.copyBufferToImage(srcBuffer, texture->image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
+	textureSubImage(texture, pixels, vk::DeviceSize(width) * height * channels, std::span(&region, 1), 1, 1);
+}
+
+void RenderContext::textureSubImage(RenderTexture* texture, const void* data, vk::DeviceSize size, std::span<const vk::BufferImageCopy> regions, uint32_t levelCount, uint32_t layerCount) {
+	auto cmd = transferCommandPool.allocate(vk::CommandBufferLevel::ePrimary);
+	cmd.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+
+	auto srcBuffer = _createStagingBuffer(size, data);
+
+	vk::ImageSubresourceRange subresourceRange {
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.levelCount = levelCount,
+			.layerCount = layerCount
+	};
+
+	vk::ImageMemoryBarrier copy_barrier{
+			.dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+			.oldLayout = vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eTransferDstOptimal,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = texture->image,
+			.subresourceRange = subresourceRange
+	};
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eHost, vk::PipelineStageFlagBits::eTransfer, {}, 0, nullptr, 0, nullptr, 1, &copy_barrier);
+
+	cmd.copyBufferToImage(srcBuffer, texture->image, vk::ImageLayout::eTransferDstOptimal, uint32_t(regions.size()), regions.data());
 
 	vk::ImageMemoryBarrier use_barrier{
 			.srcAccessMask = vk::AccessFlagBits::eTransferWrite,
@@ -465,24 +1154,64 @@ void RenderContext::textureSubImage2D(RenderTexture* texture, uint32_t width, ui
 			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
 			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
 			.image = texture->image,
-			.subresourceRange = {
-					.aspectMask = vk::ImageAspectFlagBits::eColor,
-					.levelCount = 1,
-					.layerCount = 1,
-			}
+			.subresourceRange = subresourceRange
 	};
 
-	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, 0, nullptr, 0, nullptr, 1, &use_barrier);
-	cmd.end();
+	if (core->transferFamily() != core->graphicsFamily()) {
+		// release on the transfer queue, the matching acquire is recorded at the start of the next frame
+		use_barrier.dstAccessMask = {};
+		use_barrier.srcQueueFamilyIndex = core->transferFamily();
+		use_barrier.dstQueueFamilyIndex = core->graphicsFamily();
 
-	vk::SubmitInfo submitInfo{
-		.commandBufferCount = 1,
-		.pCommandBuffers = &cmd
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, 0, nullptr, 0, nullptr, 1, &use_barrier);
+
+		use_barrier.srcAccessMask = {};
+		use_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+		imageAcquireBarriers.emplace_back(use_barrier);
+	} else {
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, 0, nullptr, 0, nullptr, 1, &use_barrier);
+	}
+
+	_submitUpload(cmd, srcBuffer);
+}
+
+void RenderContext::bufferSubData(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize size, const void* data) {
+	auto cmd = transferCommandPool.allocate(vk::CommandBufferLevel::ePrimary);
+	cmd.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+
+	auto srcBuffer = _createStagingBuffer(size, data);
+
+	vk::BufferCopy region{
+			.srcOffset = 0,
+			.dstOffset = offset,
+			.size = size
 	};
-	core->graphicsQueue().submit(1, &submitInfo, nullptr);
-	core->graphicsQueue().waitIdle();
 
-	commandPool.free(cmd);
+	cmd.copyBuffer(srcBuffer, buffer, 1, &region);
 
-	srcBuffer.destroy();
-}
\ No newline at end of file
+	vk::BufferMemoryBarrier use_barrier{
+			.srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+			.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = buffer,
+			.offset = offset,
+			.size = size
+	};
+
+	if (core->transferFamily() != core->graphicsFamily()) {
+		use_barrier.dstAccessMask = {};
+		use_barrier.srcQueueFamilyIndex = core->transferFamily();
+		use_barrier.dstQueueFamilyIndex = core->graphicsFamily();
+
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, 0, nullptr, 1, &use_barrier, 0, nullptr);
+
+		use_barrier.srcAccessMask = {};
+		use_barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead;
+		bufferAcquireBarriers.emplace_back(use_barrier);
+	} else {
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, {}, 0, nullptr, 1, &use_barrier, 0, nullptr);
+	}
+
+	_submitUpload(cmd, srcBuffer);
+}
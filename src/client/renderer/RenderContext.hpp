@@ -1,30 +1,78 @@
 #pragma once
 
 #include "RenderSystem.hpp"
+#include "GpuProfiler.hpp"
+#include "BindlessTextures.hpp"
+#include "InstanceBuffer.hpp"
+#include "DynamicResolution.hpp"
 
 #include "client/util/DescriptorPool.hpp"
 #include "client/util/CommandPool.hpp"
+#include "client/util/Buffer.hpp"
 
 #include <glm/mat4x4.hpp>
 
+#include <functional>
+
 struct RenderTexture {
 	VkImage image;
 	VkImageView view;
 	VkSampler sampler;
 	VmaAllocation allocation;
+	uint32_t bindlessIndex{BindlessTextures::InvalidIndex};
+	BindlessTextures::Binding bindlessBinding{BindlessTextures::Texture2D};
 };
 
 struct CameraTransform {
 	glm::mat4 camera;
 };
 
+// fragment stage push constant that follows the camera transform
+struct TextureConstants {
+	uint32_t textureIndex;
+};
+
+enum class LatencyMode {
+	Default,
+	Low
+};
+
+struct PendingUpload {
+	uint64_t value;
+	vk::CommandBuffer cmd;
+	Buffer stagingBuffer;
+};
+
+struct SecondaryCommandPool {
+	CommandPool commandPool;
+	std::vector<vk::CommandBuffer> commandBuffers;
+	size_t used = 0;
+};
+
+using RecordCallback = std::function<void(vk::CommandBuffer)>;
+
+// a named group of draws recorded into its own secondary command buffer and profiled as one scope
+struct DrawGroup {
+	std::string_view name;
+	RecordCallback record;
+};
+
+// receives tightly packed rgba8 rows of a finished frame
+using CaptureCallback = std::function<void(uint32_t width, uint32_t height, const void* pixels)>;
+
 struct RenderContext {
+	inline static constexpr uint32_t MaxFramesInFlight = 3;
+
 	RenderSystem* core = RenderSystem::Instance();
 
 	CommandPool commandPool;
+	CommandPool transferCommandPool;
 	DescriptorPool descriptorPool;
+	BindlessTextures bindlessTextures;
+	InstanceBuffer instanceBuffer;
 
-	RenderContext();
+	// the extent is only used without a window, where frames are rendered into offscreen images
+	explicit RenderContext(vk::Extent2D offscreenExtent = {1280, 720});
 	~RenderContext();
 
 private:
@@ -34,53 +82,156 @@ private:
 	static vk::PresentModeKHR _selectPresentMode(std::span<const vk::PresentModeKHR> present_modes, std::span<const vk::PresentModeKHR> request_modes);
 
 	void _createSwapchain();
+	void _recreateSwapchain();
+	void _updateRenderArea();
+	void _createOffscreenImages(vk::Extent2D extent);
+	void _destroyOffscreenImages();
 	void _createRenderPass();
-	void _createSyncObjects();
+	void _createOverlayRenderPass();
+	void _createImageObjects();
 	void _createFrameObjects();
+	void _createUploadObjects();
+	void _destroyImageObjects();
+	void _destroyFrameObjects();
+
+	Buffer _createStagingBuffer(vk::DeviceSize size, const void* data);
+	void _submitUpload(vk::CommandBuffer cmd, Buffer stagingBuffer);
+	void _collectUploads();
+	void _acquireUploads(vk::CommandBuffer cmd);
+
+	vk::CommandBuffer _allocateSecondary(size_t threadIndex);
+	void _upscale(vk::CommandBuffer cmd);
+
+	void _recordCapture(vk::CommandBuffer cmd);
+	void _deliverCapture(uint32_t index);
+	void _nextFrame();
+	void _applyFramesInFlight();
 
 public:
+	// starts the scene pass, which draws into the scaled render area of the scene target
 	vk::CommandBuffer begin();
+	void execute(std::span<const DrawGroup> groups);
+	// ends the scene pass and upscales it into the frame's image, groups executed afterwards draw at native resolution
+	void beginOverlay();
 	void end();
 
-	RenderTexture* createTexture2D(vk::Format format, uint32_t width, uint32_t height);
+	RenderTexture* createTexture2D(vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevels = 1);
+	RenderTexture* createTexture2DArray(vk::Format format, uint32_t width, uint32_t height, uint32_t layers, uint32_t mipLevels);
 	RenderTexture* createDepthTexture(vk::Format format, uint32_t width, uint32_t height);
+	RenderTexture* createColorTarget(vk::Format format, uint32_t width, uint32_t height);
+	void destroyTexture(RenderTexture* texture);
 	void textureSubImage2D(RenderTexture* texture, uint32_t width, uint32_t height, int channels, const void* pixels);
+	// uploads every region from one staging copy of data and transitions levelCount mips of layerCount layers for sampling
+	void textureSubImage(RenderTexture* texture, const void* data, vk::DeviceSize size, std::span<const vk::BufferImageCopy> regions, uint32_t levelCount, uint32_t layerCount);
+	void bufferSubData(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize size, const void* data);
 
 public:
+	// the native size, the scene renders at a fraction of it while dynamic resolution is enabled
 	void setRenderSize(int width, int height) {
-		renderArea.extent.width = width;
-		renderArea.extent.height = height;
+		outputExtent.width = width;
+		outputExtent.height = height;
+		renderArea.extent = dynamicResolution.apply(outputExtent);
+
+		// a resized window needs a new swapchain, it is recreated before the next frame
+		if (!core->headless() && (uint32_t(width) != surfaceExtent.width || uint32_t(height) != surfaceExtent.height)) {
+			swapchainDirty = true;
+		}
 	}
 
+	void setFramesInFlight(uint32_t count);
+	void setLatencyMode(LatencyMode mode);
+	// falls back to the closest supported mode, presentMode holds the one in use
+	void setPresentMode(vk::PresentModeKHR mode);
+
+	// copies the next submitted frame back to the host, only supported when rendering offscreen
+	void requestCapture(CaptureCallback callback);
+
+	// recorded into the primary command buffer outside of the render pass, e.g. compute passes
+	// that feed the frame's indirect draws or read back its depth attachment
+	std::vector<RecordCallback> beforeRenderPass;
+	std::vector<RecordCallback> afterRenderPass;
+
 //private:
 
+	// frameIndex/frameCount address the frames in flight, imageIndex/imageCount the swapchain images
 	uint32_t frameIndex = 0;
-	uint32_t frameCount = 0;
-	uint32_t semaphoreIndex = 0;
+	uint32_t frameCount = 2;
+	uint64_t frameNumber = 0;
+	uint32_t imageIndex = 0;
+	uint32_t imageCount = 0;
+
+	uint32_t requestedFrameCount = 2;
+	LatencyMode latencyMode = LatencyMode::Default;
+	bool framesDirty = false;
 
 	vk::Format depthFormat;
 
+	// the scene pass covers renderArea, the overlay pass the whole outputExtent
+	vk::Extent2D outputExtent;
 	vk::Rect2D renderArea;
+	DynamicResolution dynamicResolution;
+
+	// the scene pass draws color and depth into targets the size of the surface, the overlay pass draws
+	// on top of the upscaled image without depth
 	vk::RenderPass renderPass;
+	vk::RenderPass overlayRenderPass;
+	vk::RenderPass activeRenderPass;
+	vk::Framebuffer activeFramebuffer;
 
 	vk::Extent2D surfaceExtent;
 	vk::SurfaceFormatKHR surfaceFormat;
 	vk::PresentModeKHR presentMode;
+	vk::PresentModeKHR requestedPresentMode = vk::PresentModeKHR::eFifo;
 
 	vk::SwapchainKHR swapchain;
+	bool swapchainDirty = false;
+	// bumped whenever the images that depend on the swapchain are recreated, so users of the depth texture can tell
+	uint32_t surfaceVersion = 0;
 
-// frame objects
-
-	std::vector<vk::Fence> fences;
-	std::vector<vk::Semaphore> imageAcquiredSemaphore;
-	std::vector<vk::Semaphore> renderCompleteSemaphore;
+// image objects
 
 	std::vector<vk::Image> swapchainImages;
 	std::vector<vk::ImageView> swapchainImageViews;
-
-	std::vector<RenderTexture*> depthTextures;
+	std::vector<vk::Semaphore> renderCompleteSemaphore;
 	std::vector<vk::Framebuffer> framebuffers;
 
+	RenderTexture* depthTexture{nullptr};
+	RenderTexture* sceneTexture{nullptr};
+	vk::Framebuffer sceneFramebuffer;
+
+	// backing memory of the offscreen images that stand in for the swapchain when headless
+	std::vector<VmaAllocation> offscreenAllocations;
+
+// frame objects
+
+	std::vector<vk::Fence> fences;
+	std::vector<vk::Semaphore> imageAcquiredSemaphore;
+
 	std::vector<CommandPool> commandPools;
 	std::vector<vk::CommandBuffer> commandBuffers;
+
+	// one pool per frame in flight and recording thread, indexed by frameIndex * threadCount + threadIndex
+	uint32_t threadCount = 0;
+	std::vector<SecondaryCommandPool> secondaryCommandPools;
+
+	// sized for MaxFramesInFlight so that its history survives changes to the frame count
+	GpuProfiler profiler;
+	uint32_t frameScope = GpuProfiler::InvalidScope;
+
+	// gpu time in milliseconds of the most recently completed frame
+	double gpuFrameTime = 0.0;
+
+	CaptureCallback captureRequest;
+	std::vector<CaptureCallback> captureCallbacks;
+	std::vector<Buffer> captureBuffers;
+
+// upload objects
+
+	vk::Semaphore uploadSemaphore;
+	uint64_t uploadValue = 0;
+	uint64_t uploadWaitValue = 0;
+
+	std::vector<PendingUpload> pendingUploads;
+	std::vector<vk::ImageMemoryBarrier> imageAcquireBarriers;
+	std::vector<vk::BufferMemoryBarrier> bufferAcquireBarriers;
 };
\ No newline at end of file
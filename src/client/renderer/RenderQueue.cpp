@@ -0,0 +1,151 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <bit>
+
+void RenderQueue::clear() {
+	packets.clear();
+	entries.clear();
+	pipelineIds.clear();
+	descriptorSetIds.clear();
+}
+
+void RenderQueue::submit(const DrawPacket& packet) {
+	const auto key = makeKey(packet.layer, _pipelineId(packet.pipeline), _descriptorSetId(packet.descriptorSet), packet.depth);
+
+	entries.emplace_back(SortEntry{key, uint32_t(packets.size())});
+	packets.emplace_back(packet);
+}
+
+uint64_t RenderQueue::makeKey(RenderLayer layer, uint32_t pipelineId, uint32_t descriptorSetId, float depth) {
+	// non-negative floats order like their bit patterns, translucent draws invert them to sort back to front
+	auto depthBits = std::bit_cast<uint32_t>(std::max(depth, 0.0f));
+	if (layer == RenderLayer::Translucent) {
+		depthBits = ~depthBits;
+	}
+
+	const auto pipelineBits = uint64_t(pipelineId & ((1u << PipelineBits) - 1));
+	const auto descriptorSetBits = uint64_t(descriptorSetId & ((1u << DescriptorSetBits) - 1));
+
+	uint64_t key = uint64_t(layer) & ((1u << LayerBits) - 1);
+
+	// blending needs the whole layer back to front, so depth goes right below the layer and state only breaks ties
+	if (layer == RenderLayer::Translucent) {
+		key = (key << DepthBits) | depthBits;
+		key = (key << PipelineBits) | pipelineBits;
+		key = (key << DescriptorSetBits) | descriptorSetBits;
+		return key;
+	}
+
+	key = (key << PipelineBits) | pipelineBits;
+	key = (key << DescriptorSetBits) | descriptorSetBits;
+	key = (key << DepthBits) | depthBits;
+	return key;
+}
+
+// lsd radix sort over bytes, passes whose byte is the same for every key are skipped
+void RenderQueue::sort() {
+	const size_t count = entries.size();
+	if (count < 2) {
+		return;
+	}
+
+	scratch.resize(count);
+
+	uint32_t histograms[8][256] {};
+	for (auto& entry : entries) {
+		for (int pass = 0; pass < 8; pass++) {
+			histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	auto* src = entries.data();
+	auto* dst = scratch.data();
+
+	for (int pass = 0; pass < 8; pass++) {
+		auto& histogram = histograms[pass];
+		if (histogram[(src[0].key >> (pass * 8)) & 0xFF] == count) {
+			continue;
+		}
+
+		uint32_t offsets[256];
+		uint32_t sum = 0;
+		for (int i = 0; i < 256; i++) {
+			offsets[i] = sum;
+			sum += histogram[i];
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			dst[offsets[(src[i].key >> (pass * 8)) & 0xFF]++] = src[i];
+		}
+		std::swap(src, dst);
+	}
+
+	if (src != entries.data()) {
+		entries.swap(scratch);
+	}
+}
+
+void RenderQueue::record(vk::CommandBuffer cmd) {
+	Stats stats{};
+
+	vk::Pipeline pipeline;
+	vk::PipelineLayout pipelineLayout;
+	vk::DescriptorSet descriptorSet;
+	vk::DescriptorSet instanceSet;
+	vk::Buffer vertexBuffer;
+	vk::Buffer indexBuffer;
+
+	for (auto& entry : entries) {
+		auto& packet = packets[entry.index];
+
+		if (packet.pipeline != pipeline) {
+			cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, packet.pipeline);
+			pipeline = packet.pipeline;
+			stats.pipelineBinds++;
+		}
+
+		// sets stay bound across pipelines that share a layout
+		if (packet.descriptorSet != descriptorSet || packet.pipelineLayout != pipelineLayout) {
+			cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, packet.pipelineLayout, 0, 1, &packet.descriptorSet, 0, nullptr);
+			descriptorSet = packet.descriptorSet;
+			pipelineLayout = packet.pipelineLayout;
+			instanceSet = nullptr;
+			stats.descriptorSetBinds++;
+		}
+
+		if (packet.instanceSet && packet.instanceSet != instanceSet) {
+			cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, packet.pipelineLayout, 1, 1, &packet.instanceSet, 0, nullptr);
+			instanceSet = packet.instanceSet;
+			stats.descriptorSetBinds++;
+		}
+
+		if (packet.vertexBuffer != vertexBuffer) {
+			vk::DeviceSize offset{0};
+			cmd.bindVertexBuffers(0, 1, &packet.vertexBuffer, &offset);
+			vertexBuffer = packet.vertexBuffer;
+			stats.bufferBinds++;
+		}
+		if (packet.indexBuffer != indexBuffer) {
+			cmd.bindIndexBuffer(packet.indexBuffer, 0, vk::IndexType::eUint32);
+			indexBuffer = packet.indexBuffer;
+			stats.bufferBinds++;
+		}
+
+		cmd.pushConstants(packet.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(CameraTransform), &packet.transform);
+		cmd.pushConstants(packet.pipelineLayout, vk::ShaderStageFlagBits::eFragment, sizeof(CameraTransform), sizeof(TextureConstants), &packet.textureConstants);
+
+		cmd.drawIndexed(packet.indexCount, packet.instanceCount, packet.firstIndex, packet.vertexOffset, packet.firstInstance);
+		stats.draws++;
+	}
+
+	lastStats = stats;
+}
+
+uint32_t RenderQueue::_pipelineId(vk::Pipeline pipeline) {
+	return pipelineIds.try_emplace(VkPipeline(pipeline), uint32_t(pipelineIds.size())).first->second;
+}
+
+uint32_t RenderQueue::_descriptorSetId(vk::DescriptorSet descriptorSet) {
+	return descriptorSetIds.try_emplace(VkDescriptorSet(descriptorSet), uint32_t(descriptorSetIds.size())).first->second;
+}
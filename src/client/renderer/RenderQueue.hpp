@@ -0,0 +1,92 @@
+#pragma once
+
+#include "RenderContext.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// coarse draw order, the top bits of every sort key
+enum class RenderLayer : uint8_t {
+	Opaque,
+	AlphaTest,
+	Translucent,
+	Overlay
+};
+
+// everything a single indexed draw needs, the queue records it without calling back into the renderer
+struct DrawPacket {
+	RenderLayer layer;
+	vk::Pipeline pipeline;
+	vk::PipelineLayout pipelineLayout;
+	vk::DescriptorSet descriptorSet;
+	// set 1 of instanced pipelines, null otherwise
+	vk::DescriptorSet instanceSet;
+	// distance from the camera, opaque layers draw front to back and translucent ones back to front
+	float depth;
+
+	vk::Buffer vertexBuffer;
+	vk::Buffer indexBuffer;
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t instanceCount;
+	uint32_t firstInstance;
+
+	CameraTransform transform;
+	TextureConstants textureConstants;
+};
+
+// draws submitted during a frame, sorted once by a 64 bit key and recorded with redundant binds skipped.
+// key layout from the top: layer (4 bits), pipeline (14), descriptor set (14), depth (32). the translucent
+// layer puts its inverted depth right below the layer instead, so it draws back to front across pipelines
+struct RenderQueue {
+	inline static constexpr uint32_t LayerBits = 4;
+	inline static constexpr uint32_t PipelineBits = 14;
+	inline static constexpr uint32_t DescriptorSetBits = 14;
+	inline static constexpr uint32_t DepthBits = 32;
+
+	// counts from the last record, to see how much state sorting saved
+	struct Stats {
+		uint32_t draws = 0;
+		uint32_t pipelineBinds = 0;
+		uint32_t descriptorSetBinds = 0;
+		uint32_t bufferBinds = 0;
+	};
+
+	void clear();
+	void submit(const DrawPacket& packet);
+
+	// radix sorts the keys, must run before record
+	void sort();
+	void record(vk::CommandBuffer cmd);
+
+	size_t size() const {
+		return packets.size();
+	}
+
+	const Stats& stats() const {
+		return lastStats;
+	}
+
+	static uint64_t makeKey(RenderLayer layer, uint32_t pipelineId, uint32_t descriptorSetId, float depth);
+
+private:
+	struct SortEntry {
+		uint64_t key;
+		uint32_t index;
+	};
+
+	uint32_t _pipelineId(vk::Pipeline pipeline);
+	uint32_t _descriptorSetId(vk::DescriptorSet descriptorSet);
+
+	std::vector<DrawPacket> packets;
+	std::vector<SortEntry> entries;
+	std::vector<SortEntry> scratch;
+
+	// ids are handed out in submission order and reset every frame, so they always fit their key bits
+	std::unordered_map<VkPipeline, uint32_t> pipelineIds;
+	std::unordered_map<VkDescriptorSet, uint32_t> descriptorSetIds;
+
+	Stats lastStats;
+};
@@ -1,5 +1,7 @@
 #include "RenderSystem.hpp"
 
+#include <cstring>
+
 namespace {
 	inline static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData) {
 		std::cout << pCallbackData->pMessage << std::endl;
@@ -16,13 +18,25 @@ namespace {
 }
 
 void RenderSystem::init(GLFWwindow *window) {
-	auto extensions = getRequiredExtension();
-	extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	_headless = window == nullptr;
+
+	auto extensions = _headless ? std::vector<const char *>{} : getRequiredExtension();
+
+	// headless machines usually run without the sdk, so validation is only enabled when it is installed
+	std::vector<const char *> layers{};
+	for (auto layer : enabledLayers) {
+		if (_layerSupported(layer)) {
+			layers.push_back(layer);
+		}
+	}
+	if (!layers.empty()) {
+		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
 
 	vk::InstanceCreateInfo instanceCreateInfo {
 			.pApplicationInfo = &appInfo,
-			.enabledLayerCount = std::size(enabledLayers),
-			.ppEnabledLayerNames = std::data(enabledLayers),
+			.enabledLayerCount = uint32_t(layers.size()),
+			.ppEnabledLayerNames = layers.data(),
 			.enabledExtensionCount = uint32_t(extensions.size()),
 			.ppEnabledExtensionNames = extensions.data(),
 	};
@@ -38,16 +52,22 @@ void RenderSystem::init(GLFWwindow *window) {
 			.pfnUserCallback = DebugCallback,
 	};
 
-	createDebugUtilsMessengerEXT(_instance, &debugCreateInfo, nullptr, &debugUtilsMessenger);
+	if (!layers.empty()) {
+		createDebugUtilsMessengerEXT(_instance, &debugCreateInfo, nullptr, &debugUtilsMessenger);
+	}
 
-	glfwCreateWindowSurface(_instance, window, nullptr, &_surface);
+	if (!_headless) {
+		glfwCreateWindowSurface(_instance, window, nullptr, &_surface);
+	}
 
 	_selectPhysicalDevice();
 
+	_transferFamily = _findTransferFamily(_physicalDevice);
+
 	const float queuePriority = 1.0f;
 
 	std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos{};
-	queueCreateInfos.reserve(2);
+	queueCreateInfos.reserve(3);
 
 	vk::DeviceQueueCreateInfo graphicsQueueCreateInfo {
 			.queueFamilyIndex = _graphicsFamily,
@@ -66,20 +86,46 @@ void RenderSystem::init(GLFWwindow *window) {
 		queueCreateInfos.emplace_back(presentQueueCreateInfo);
 	}
 
+	if (_transferFamily != _graphicsFamily && _transferFamily != _presentFamily) {
+		vk::DeviceQueueCreateInfo transferQueueCreateInfo {
+				.queueFamilyIndex = _transferFamily,
+				.queueCount = 1,
+				.pQueuePriorities = &queuePriority
+		};
+
+		queueCreateInfos.emplace_back(transferQueueCreateInfo);
+	}
+
+	// pipeline statistics are only used by the profiler, bc formats only by the texture cache and indirect
+	// draws only by the gpu culler, so they are enabled when available instead of required
+	auto supportedFeatures = _physicalDevice.getFeatures();
+	auto supportedFeatures12 = _physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>().get<vk::PhysicalDeviceVulkan12Features>();
+	auto enabledFeatures = features;
+	auto enabledFeatures12 = features12;
+	enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+	enabledFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	enabledFeatures12.drawIndirectCount = supportedFeatures12.drawIndirectCount;
+	_pipelineStatisticsSupported = enabledFeatures.pipelineStatisticsQuery;
+	_textureCompressionBCSupported = enabledFeatures.textureCompressionBC;
+	_gpuCullingSupported = enabledFeatures.multiDrawIndirect && enabledFeatures12.drawIndirectCount;
+
 	vk::DeviceCreateInfo deviceCreateInfo {
+			.pNext = &enabledFeatures12,
 			.queueCreateInfoCount = uint32_t(std::size(queueCreateInfos)),
 			.pQueueCreateInfos = std::data(queueCreateInfos),
 //			.enabledLayerCount = std::size(enabledLayers),
 //			.ppEnabledLayerNames = std::data(enabledLayers),
-			.enabledExtensionCount = std::size(device_extensions),
+			.enabledExtensionCount = _headless ? 0u : uint32_t(std::size(device_extensions)),
 			.ppEnabledExtensionNames = std::data(device_extensions),
-			.pEnabledFeatures = &features
+			.pEnabledFeatures = &enabledFeatures
 	};
 
 	_device = _physicalDevice.createDevice(deviceCreateInfo, nullptr);
 
 	_presentQueue = _device.getQueue(_presentFamily, 0);
 	_graphicsQueue = _device.getQueue(_graphicsFamily, 0);
+	_transferQueue = _device.getQueue(_transferFamily, 0);
 
 	VmaAllocatorCreateInfo allocatorCreateInfo{
 			.physicalDevice = _physicalDevice,
@@ -96,10 +142,21 @@ void RenderSystem::terminate() {
 
 	_device.destroy(nullptr);
 
-	_instance.destroySurfaceKHR(_surface, nullptr);
+	if (_surface != nullptr) {
+		_instance.destroySurfaceKHR(_surface, nullptr);
+	}
 	_instance.destroy(nullptr);
 }
 
+bool RenderSystem::_layerSupported(const char* name) {
+	for (auto& properties : vk::enumerateInstanceLayerProperties()) {
+		if (std::strcmp(properties.layerName.data(), name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
 bool RenderSystem::_selectPhysicalDevice() {
 	auto physicalDevices = _instance.enumeratePhysicalDevices();
 
@@ -108,6 +165,11 @@ bool RenderSystem::_selectPhysicalDevice() {
 			continue;
 		}
 
+		if (_headless) {
+			_physicalDevice = physicalDevice;
+			return true;
+		}
+
 		uint32_t surface_format_count = 0;
 		physicalDevice.getSurfaceFormatsKHR(_surface, &surface_format_count, nullptr);
 		if (surface_format_count == 0) {
@@ -137,7 +199,9 @@ bool RenderSystem::_findQueueFamilies(vk::PhysicalDevice device, vk::SurfaceKHR
 			graphics_family = i;
 		}
 
-		if (device.getSurfaceSupportKHR(i, surface)) {
+		if (surface == nullptr) {
+			present_family = graphics_family;
+		} else if (device.getSurfaceSupportKHR(i, surface)) {
 			present_family = i;
 		}
 
@@ -150,6 +214,27 @@ bool RenderSystem::_findQueueFamilies(vk::PhysicalDevice device, vk::SurfaceKHR
 	return false;
 }
 
+uint32_t RenderSystem::_findTransferFamily(vk::PhysicalDevice device) {
+	const auto properties = device.getQueueFamilyProperties();
+
+	// prefer a transfer-only family (DMA engine), then any non-graphics family that can transfer
+	for (uint32_t i = 0; i < uint32_t(properties.size()); i++) {
+		auto flags = properties[i].queueFlags;
+		if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) {
+			return i;
+		}
+	}
+
+	for (uint32_t i = 0; i < uint32_t(properties.size()); i++) {
+		auto flags = properties[i].queueFlags;
+		if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics)) {
+			return i;
+		}
+	}
+
+	return _graphicsFamily;
+}
+
 bool RenderSystem::_formatSupported(vk::Format format, vk::ImageTiling tiling, vk::FormatFeatureFlags flags) {
 	vk::FormatProperties formatProperties = _physicalDevice.getFormatProperties(format);
 
@@ -175,5 +260,5 @@ vk::Format RenderSystem::_findSupportedFormat(std::span<const vk::Format> format
 
 vk::Format RenderSystem::getSupportedDepthFormat() {
 	static constinit vk::Format formats[] { vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint, vk::Format::eD32Sfloat };
-	return _findSupportedFormat(formats, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment);
+	return _findSupportedFormat(formats, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage);
 }
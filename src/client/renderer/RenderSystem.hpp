@@ -34,6 +34,16 @@ struct RenderSystem {
 			.samplerAnisotropy = VK_TRUE
 	};
 
+	inline static constexpr vk::PhysicalDeviceVulkan12Features features12 {
+			.descriptorIndexing = VK_TRUE,
+			.shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+			.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+			.descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+			.descriptorBindingPartiallyBound = VK_TRUE,
+			.runtimeDescriptorArray = VK_TRUE,
+			.timelineSemaphore = VK_TRUE
+	};
+
 	inline static RenderSystem* Instance() {
 		static /*constinit*/ RenderSystem graphics;
 		return &graphics;
@@ -45,6 +55,7 @@ struct RenderSystem {
 		return std::vector<const char *>(extensions, extensions + count);
 	}
 
+	// a null window selects the headless path: no surface, no swapchain extension, rendering goes to offscreen images
 	void init(GLFWwindow* window);
 
 	void terminate();
@@ -52,7 +63,10 @@ struct RenderSystem {
 private:
 	bool _selectPhysicalDevice();
 
+	bool _layerSupported(const char* name);
+
 	bool _findQueueFamilies(vk::PhysicalDevice device, vk::SurfaceKHR surface);
+	uint32_t _findTransferFamily(vk::PhysicalDevice device);
 
 	bool _formatSupported(vk::Format format, vk::ImageTiling tiling, vk::FormatFeatureFlags flags);
 
@@ -82,6 +96,23 @@ public:
 		return _surface;
 	}
 
+	bool headless() {
+		return _headless;
+	}
+
+	bool pipelineStatisticsSupported() {
+		return _pipelineStatisticsSupported;
+	}
+
+	bool textureCompressionBCSupported() {
+		return _textureCompressionBCSupported;
+	}
+
+	// multi draw indirect and indirect count, the gpu culler draws everything it keeps with one call
+	bool gpuCullingSupported() {
+		return _gpuCullingSupported;
+	}
+
 	uint32_t graphicsFamily() {
 		return _graphicsFamily;
 	}
@@ -90,6 +121,10 @@ public:
 		return _presentFamily;
 	}
 
+	uint32_t transferFamily() {
+		return _transferFamily;
+	}
+
 	vk::Queue graphicsQueue() {
 		return _graphicsQueue;
 	}
@@ -98,6 +133,10 @@ public:
 		return _presentQueue;
 	}
 
+	vk::Queue transferQueue() {
+		return _transferQueue;
+	}
+
 private:
 	vk::Instance _instance;
 	vk::PhysicalDevice _physicalDevice;
@@ -107,10 +146,16 @@ private:
 
 	VkDebugUtilsMessengerEXT debugUtilsMessenger{nullptr};
 	VkSurfaceKHR _surface{nullptr};
+	bool _headless{false};
+	bool _pipelineStatisticsSupported{false};
+	bool _textureCompressionBCSupported{false};
+	bool _gpuCullingSupported{false};
 
 	uint32_t _graphicsFamily{0};
 	uint32_t _presentFamily{0};
+	uint32_t _transferFamily{0};
 
 	vk::Queue _presentQueue;
 	vk::Queue _graphicsQueue;
+	vk::Queue _transferQueue;
 };
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <cstdint>
+
 struct TextureUVCoordinateSet {
     float minU;
     float minV;
     float maxU;
     float maxV;
+    // layer in the block texture array, uvs are tile-local there; always 0 for the 2d atlas
+    uint32_t layer = 0;
 
     inline constexpr float getInterpolatedU(float t) const {
         return (1 - t) * minU + t * maxU;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "client/renderer/RenderContext.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+// six planes (xyz = normal pointing inside, w = distance) extracted from a view projection with a 0..1 depth range
+struct Frustum {
+	enum Plane {
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far
+	};
+
+	std::array<glm::vec4, 6> planes;
+
+	static Frustum extract(const glm::mat4& m) {
+		auto row = [&m](int i) {
+			return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+		};
+
+		const auto r0 = row(0);
+		const auto r1 = row(1);
+		const auto r2 = row(2);
+		const auto r3 = row(3);
+
+		Frustum frustum{};
+		frustum.planes[Left] = r3 + r0;
+		frustum.planes[Right] = r3 - r0;
+		frustum.planes[Bottom] = r3 + r1;
+		frustum.planes[Top] = r3 - r1;
+		frustum.planes[Near] = r2;
+		frustum.planes[Far] = r3 - r2;
+
+		for (auto& plane : frustum.planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	static Frustum extract(const CameraTransform& transform) {
+		return extract(transform.camera);
+	}
+};
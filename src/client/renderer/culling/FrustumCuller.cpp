@@ -0,0 +1,82 @@
+#include "FrustumCuller.hpp"
+
+#include <bit>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VCRAFT_FRUSTUM_SSE2 1
+#endif
+
+// a box is outside when its corner furthest along a plane's normal is still behind that plane.
+// the corner is picked per plane, so the batch only selects between the min and max arrays
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+	const size_t count = size();
+	size_t i = 0;
+
+#if defined(__AVX__)
+	for (; i + 8 <= count; i += 8) {
+		__m256 outside = _mm256_setzero_ps();
+
+		for (auto& plane : frustum.planes) {
+			const __m256 x = _mm256_loadu_ps((plane.x > 0.0f ? maxX : minX).data() + i);
+			const __m256 y = _mm256_loadu_ps((plane.y > 0.0f ? maxY : minY).data() + i);
+			const __m256 z = _mm256_loadu_ps((plane.z > 0.0f ? maxZ : minZ).data() + i);
+
+			__m256 distance = _mm256_set1_ps(plane.w);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(x, _mm256_set1_ps(plane.x)));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(y, _mm256_set1_ps(plane.y)));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(plane.z)));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		auto inside = ~uint32_t(_mm256_movemask_ps(outside)) & 0xFFu;
+		while (inside != 0) {
+			visible.push_back(uint32_t(i) + uint32_t(std::countr_zero(inside)));
+			inside &= inside - 1;
+		}
+	}
+#elif VCRAFT_FRUSTUM_SSE2
+	for (; i + 4 <= count; i += 4) {
+		__m128 outside = _mm_setzero_ps();
+
+		for (auto& plane : frustum.planes) {
+			const __m128 x = _mm_loadu_ps((plane.x > 0.0f ? maxX : minX).data() + i);
+			const __m128 y = _mm_loadu_ps((plane.y > 0.0f ? maxY : minY).data() + i);
+			const __m128 z = _mm_loadu_ps((plane.z > 0.0f ? maxZ : minZ).data() + i);
+
+			__m128 distance = _mm_set1_ps(plane.w);
+			distance = _mm_add_ps(distance, _mm_mul_ps(x, _mm_set1_ps(plane.x)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+
+		const auto mask = _mm_movemask_ps(outside);
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			if ((mask & (1 << lane)) == 0) {
+				visible.push_back(uint32_t(i) + lane);
+			}
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		bool inside = true;
+		for (auto& plane : frustum.planes) {
+			const float x = plane.x > 0.0f ? maxX[i] : minX[i];
+			const float y = plane.y > 0.0f ? maxY[i] : minY[i];
+			const float z = plane.z > 0.0f ? maxZ[i] : minZ[i];
+			if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+				inside = false;
+				break;
+			}
+		}
+		if (inside) {
+			visible.push_back(uint32_t(i));
+		}
+	}
+}
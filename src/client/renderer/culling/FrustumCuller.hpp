@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Frustum.hpp"
+
+#include "util/math/AABB.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// bounding boxes stored as structure of arrays and tested against a frustum in batches of 4 (sse) or 8 (avx)
+struct FrustumCuller {
+	void clear() {
+		minX.clear();
+		minY.clear();
+		minZ.clear();
+		maxX.clear();
+		maxY.clear();
+		maxZ.clear();
+	}
+
+	void reserve(size_t count) {
+		minX.reserve(count);
+		minY.reserve(count);
+		minZ.reserve(count);
+		maxX.reserve(count);
+		maxY.reserve(count);
+		maxZ.reserve(count);
+	}
+
+	// returns the index reported back by cull
+	uint32_t add(const AABB& box) {
+		minX.push_back(box.minX);
+		minY.push_back(box.minY);
+		minZ.push_back(box.minZ);
+		maxX.push_back(box.maxX);
+		maxY.push_back(box.maxY);
+		maxZ.push_back(box.maxZ);
+		return uint32_t(minX.size() - 1);
+	}
+
+	size_t size() const {
+		return minX.size();
+	}
+
+	// appends the indices of the boxes intersecting the frustum in ascending order
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+private:
+	std::vector<float> minX;
+	std::vector<float> minY;
+	std::vector<float> minZ;
+	std::vector<float> maxX;
+	std::vector<float> maxY;
+	std::vector<float> maxZ;
+};
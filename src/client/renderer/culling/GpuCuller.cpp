@@ -0,0 +1,540 @@
+#include "GpuCuller.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+	// the frustum is tested with this frame's matrix, the pyramid with the one its depth was rendered with
+	struct CullView {
+		glm::mat4 viewProjection;
+		glm::mat4 pyramidViewProjection;
+	};
+
+	struct CullConstants {
+		glm::vec2 pyramidSize;
+		uint32_t drawCount;
+		uint32_t occlusion;
+		glm::vec2 uvScale;
+	};
+
+	struct PyramidConstants {
+		int32_t sourceSize[2];
+		int32_t destinationSize[2];
+		float scale[2];
+	};
+
+	vk::ImageAspectFlags depthAspect(vk::Format format) {
+		switch (format) {
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+		default:
+			return vk::ImageAspectFlagBits::eDepth;
+		}
+	}
+}
+
+void GpuCuller::create(Handle<AppPlatform> platform, Handle<RenderContext> context) {
+	renderContext = context.get();
+
+	auto device = core->device();
+
+	vk::DescriptorPoolSize poolSizes[] {
+		{vk::DescriptorType::eStorageBuffer, RenderContext::MaxFramesInFlight * 4},
+		{vk::DescriptorType::eUniformBuffer, RenderContext::MaxFramesInFlight},
+		{vk::DescriptorType::eCombinedImageSampler, RenderContext::MaxFramesInFlight + MaxPyramidLevels},
+		{vk::DescriptorType::eStorageImage, MaxPyramidLevels}
+	};
+
+	descriptorPool = device.createDescriptorPool({
+		.maxSets = RenderContext::MaxFramesInFlight + MaxPyramidLevels,
+		.poolSizeCount = uint32_t(std::size(poolSizes)),
+		.pPoolSizes = poolSizes
+	});
+
+	vk::DescriptorSetLayoutBinding cullBindings[] {
+		{.binding = 0, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute},
+		{.binding = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute},
+		{.binding = 2, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute},
+		{.binding = 3, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute},
+		{.binding = 4, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute},
+		{.binding = 5, .descriptorType = vk::DescriptorType::eUniformBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute}
+	};
+	cullSetLayout = device.createDescriptorSetLayout({
+		.bindingCount = uint32_t(std::size(cullBindings)),
+		.pBindings = cullBindings
+	});
+
+	vk::DescriptorSetLayoutBinding pyramidBindings[] {
+		{.binding = 0, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute},
+		{.binding = 1, .descriptorType = vk::DescriptorType::eStorageImage, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute}
+	};
+	pyramidSetLayout = device.createDescriptorSetLayout({
+		.bindingCount = uint32_t(std::size(pyramidBindings)),
+		.pBindings = pyramidBindings
+	});
+
+	vk::PushConstantRange cullConstants{vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullConstants)};
+	cullPipelineLayout = device.createPipelineLayout({
+		.setLayoutCount = 1,
+		.pSetLayouts = &cullSetLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &cullConstants
+	});
+
+	vk::PushConstantRange pyramidConstants{vk::ShaderStageFlagBits::eCompute, 0, sizeof(PyramidConstants)};
+	pyramidPipelineLayout = device.createPipelineLayout({
+		.setLayoutCount = 1,
+		.pSetLayouts = &pyramidSetLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pyramidConstants
+	});
+
+	auto cullShader = _loadShader(platform, "shaders/cull.comp.spv");
+	auto pyramidShader = _loadShader(platform, "shaders/depth_pyramid.comp.spv");
+
+	vk::ComputePipelineCreateInfo pipelineCreateInfos[] {
+		{
+			.stage = {.stage = vk::ShaderStageFlagBits::eCompute, .module = cullShader, .pName = "main"},
+			.layout = cullPipelineLayout
+		},
+		{
+			.stage = {.stage = vk::ShaderStageFlagBits::eCompute, .module = pyramidShader, .pName = "main"},
+			.layout = pyramidPipelineLayout
+		}
+	};
+	device.createComputePipelines(nullptr, 1, &pipelineCreateInfos[0], nullptr, &cullPipeline);
+	device.createComputePipelines(nullptr, 1, &pipelineCreateInfos[1], nullptr, &pyramidPipeline);
+
+	device.destroyShaderModule(cullShader, nullptr);
+	device.destroyShaderModule(pyramidShader, nullptr);
+
+	sampler = device.createSampler({
+		.magFilter = vk::Filter::eNearest,
+		.minFilter = vk::Filter::eNearest,
+		.mipmapMode = vk::SamplerMipmapMode::eNearest,
+		.addressModeU = vk::SamplerAddressMode::eClampToEdge,
+		.addressModeV = vk::SamplerAddressMode::eClampToEdge,
+		.addressModeW = vk::SamplerAddressMode::eClampToEdge,
+		.minLod = 0,
+		.maxLod = VK_LOD_CLAMP_NONE
+	});
+
+	for (auto& frame : frames) {
+		frame.bounds = Buffer::create(
+			{.size = sizeof(GpuDrawBounds) * MaxDraws, .usage = vk::BufferUsageFlagBits::eStorageBuffer},
+			{.usage = VMA_MEMORY_USAGE_CPU_TO_GPU}
+		);
+		frame.commands = Buffer::create(
+			{.size = sizeof(vk::DrawIndexedIndirectCommand) * MaxDraws, .usage = vk::BufferUsageFlagBits::eStorageBuffer},
+			{.usage = VMA_MEMORY_USAGE_CPU_TO_GPU}
+		);
+		frame.visibleCommands = Buffer::create(
+			{.size = sizeof(vk::DrawIndexedIndirectCommand) * MaxDraws, .usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer},
+			{.usage = VMA_MEMORY_USAGE_GPU_ONLY}
+		);
+		frame.visibleCount = Buffer::create(
+			{.size = sizeof(uint32_t), .usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst},
+			{.usage = VMA_MEMORY_USAGE_GPU_ONLY}
+		);
+		frame.view = Buffer::create(
+			{.size = sizeof(CullView), .usage = vk::BufferUsageFlagBits::eUniformBuffer},
+			{.usage = VMA_MEMORY_USAGE_CPU_TO_GPU}
+		);
+		frame.mappedBounds = frame.bounds.map();
+		frame.mappedCommands = frame.commands.map();
+		frame.mappedView = frame.view.map();
+
+		vk::DescriptorSetAllocateInfo allocateInfo{
+			.descriptorPool = descriptorPool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &cullSetLayout
+		};
+		device.allocateDescriptorSets(&allocateInfo, &frame.descriptorSet);
+
+		vk::DescriptorBufferInfo bufferInfos[] {
+			{.buffer = frame.bounds, .offset = 0, .range = VK_WHOLE_SIZE},
+			{.buffer = frame.commands, .offset = 0, .range = VK_WHOLE_SIZE},
+			{.buffer = frame.visibleCommands, .offset = 0, .range = VK_WHOLE_SIZE},
+			{.buffer = frame.visibleCount, .offset = 0, .range = VK_WHOLE_SIZE}
+		};
+
+		vk::WriteDescriptorSet writes[std::size(bufferInfos)];
+		for (uint32_t i = 0; i < std::size(bufferInfos); i++) {
+			writes[i] = vk::WriteDescriptorSet{
+				.dstSet = frame.descriptorSet,
+				.dstBinding = i,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eStorageBuffer,
+				.pBufferInfo = &bufferInfos[i]
+			};
+		}
+		vk::DescriptorBufferInfo viewInfo{.buffer = frame.view, .offset = 0, .range = VK_WHOLE_SIZE};
+		vk::WriteDescriptorSet viewWrite{
+			.dstSet = frame.descriptorSet,
+			.dstBinding = 5,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eUniformBuffer,
+			.pBufferInfo = &viewInfo
+		};
+
+		device.updateDescriptorSets(uint32_t(std::size(writes)), writes, 0, nullptr);
+		device.updateDescriptorSets(1, &viewWrite, 0, nullptr);
+	}
+
+	for (auto& set : pyramidSets) {
+		vk::DescriptorSetAllocateInfo allocateInfo{
+			.descriptorPool = descriptorPool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &pyramidSetLayout
+		};
+		device.allocateDescriptorSets(&allocateInfo, &set);
+	}
+
+	_createPyramid(renderContext->depthTexture, renderContext->surfaceExtent);
+
+	renderContext->beforeRenderPass.emplace_back([this](vk::CommandBuffer cmd) {
+		_cull(cmd);
+	});
+	renderContext->afterRenderPass.emplace_back([this](vk::CommandBuffer cmd) {
+		_buildPyramid(cmd);
+	});
+}
+
+void GpuCuller::destroy() {
+	auto device = core->device();
+
+	_destroyPyramid();
+
+	for (auto& frame : frames) {
+		frame.bounds.unmap();
+		frame.commands.unmap();
+		frame.view.unmap();
+		frame.bounds.destroy();
+		frame.commands.destroy();
+		frame.view.destroy();
+		frame.visibleCommands.destroy();
+		frame.visibleCount.destroy();
+	}
+
+	device.destroySampler(sampler, nullptr);
+	device.destroyPipeline(cullPipeline, nullptr);
+	device.destroyPipeline(pyramidPipeline, nullptr);
+	device.destroyPipelineLayout(cullPipelineLayout, nullptr);
+	device.destroyPipelineLayout(pyramidPipelineLayout, nullptr);
+	device.destroyDescriptorSetLayout(cullSetLayout, nullptr);
+	device.destroyDescriptorSetLayout(pyramidSetLayout, nullptr);
+	device.destroyDescriptorPool(descriptorPool, nullptr);
+}
+
+void GpuCuller::setDraws(std::span<const GpuDrawBounds> bounds, std::span<const vk::DrawIndexedIndirectCommand> commands) {
+	pendingBounds.assign(bounds.begin(), bounds.end());
+	pendingCommands.assign(commands.begin(), commands.end());
+}
+
+void GpuCuller::setViewProjection(const glm::mat4& matrix) {
+	viewProjection = matrix;
+}
+
+void GpuCuller::draw(vk::CommandBuffer cmd) {
+	if (!enabled || drawCount == 0) {
+		return;
+	}
+
+	auto& frame = frames[renderContext->frameIndex];
+	cmd.drawIndexedIndirectCount(frame.visibleCommands, 0, frame.visibleCount, 0, drawCount, sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+void GpuCuller::_cull(vk::CommandBuffer cmd) {
+	if (!enabled) {
+		pyramidValid = false;
+		drawCount = 0;
+		return;
+	}
+
+	// a replaced depth attachment means every frame using the old pyramid has to finish first
+	if (renderContext->surfaceVersion != pyramidVersion) {
+		core->device().waitIdle();
+		_destroyPyramid();
+		_createPyramid(renderContext->depthTexture, renderContext->surfaceExtent);
+	}
+
+	if (!pyramidInitialized) {
+		vk::ImageMemoryBarrier barrier{
+			.srcAccessMask = {},
+			.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+			.oldLayout = vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eGeneral,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = pyramidImage,
+			.subresourceRange = {
+				.aspectMask = vk::ImageAspectFlagBits::eColor,
+				.levelCount = uint32_t(pyramidLevelViews.size()),
+				.layerCount = 1
+			}
+		};
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+		pyramidInitialized = true;
+	}
+
+	auto& frame = frames[renderContext->frameIndex];
+
+	drawCount = uint32_t(std::min<size_t>(std::min(pendingBounds.size(), pendingCommands.size()), MaxDraws));
+	std::memcpy(frame.mappedBounds, pendingBounds.data(), sizeof(GpuDrawBounds) * drawCount);
+	std::memcpy(frame.mappedCommands, pendingCommands.data(), sizeof(vk::DrawIndexedIndirectCommand) * drawCount);
+	frame.bounds.flush(0, sizeof(GpuDrawBounds) * drawCount);
+	frame.commands.flush(0, sizeof(vk::DrawIndexedIndirectCommand) * drawCount);
+
+	cmd.fillBuffer(frame.visibleCount, 0, sizeof(uint32_t), 0);
+
+	vk::MemoryBarrier clearBarrier{
+		.srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+		.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+	};
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+	if (drawCount != 0) {
+		CullView view{
+			.viewProjection = viewProjection,
+			.pyramidViewProjection = pyramidViewProjection
+		};
+		std::memcpy(frame.mappedView, &view, sizeof(view));
+		frame.view.flush(0, sizeof(view));
+
+		CullConstants constants{
+			.pyramidSize = glm::vec2(pyramidLevelExtents.front().width, pyramidLevelExtents.front().height),
+			.drawCount = drawCount,
+			.occlusion = pyramidValid ? 1u : 0u,
+			.uvScale = pyramidScale
+		};
+
+		cmd.bindPipeline(vk::PipelineBindPoint::eCompute, cullPipeline);
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cullPipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+		cmd.pushConstants(cullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullConstants), &constants);
+		cmd.dispatch((drawCount + 63) / 64, 1, 1);
+	}
+
+	vk::MemoryBarrier drawBarrier{
+		.srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+		.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead
+	};
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect, {}, 1, &drawBarrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCuller::_buildPyramid(vk::CommandBuffer cmd) {
+	if (!enabled || renderContext->surfaceVersion != pyramidVersion) {
+		return;
+	}
+
+	// the next render pass starts from an undefined layout, so the depth attachment is not transitioned back
+	vk::ImageMemoryBarrier depthBarrier{
+		.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+		.dstAccessMask = vk::AccessFlagBits::eShaderRead,
+		.oldLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+		.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = pyramidSource->image,
+		.subresourceRange = {
+			.aspectMask = depthAspect(renderContext->depthFormat),
+			.levelCount = 1,
+			.layerCount = 1
+		}
+	};
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eLateFragmentTests, vk::PipelineStageFlagBits::eComputeShader, {}, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+
+	cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pyramidPipeline);
+
+	vk::ImageMemoryBarrier levelBarrier{
+		.srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+		.dstAccessMask = vk::AccessFlagBits::eShaderRead,
+		.oldLayout = vk::ImageLayout::eGeneral,
+		.newLayout = vk::ImageLayout::eGeneral,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = pyramidImage,
+		.subresourceRange = {
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.levelCount = 1,
+			.layerCount = 1
+		}
+	};
+
+	// a scaled frame only covers the top left of the depth attachment, the rest is never read.
+	// the first level maps the whole attachment, reads past the render area are clamped to its edge
+	vk::Extent2D source = renderContext->renderArea.extent;
+	vk::Extent2D sourceFootprint = depthExtent;
+	pyramidScale = glm::vec2(float(source.width) / float(depthExtent.width), float(source.height) / float(depthExtent.height));
+	pyramidViewProjection = viewProjection;
+
+	for (uint32_t level = 0; level < uint32_t(pyramidLevelViews.size()); level++) {
+		auto destination = pyramidLevelExtents[level];
+
+		PyramidConstants constants{
+			.sourceSize = {int32_t(source.width), int32_t(source.height)},
+			.destinationSize = {int32_t(destination.width), int32_t(destination.height)},
+			.scale = {float(sourceFootprint.width) / float(destination.width), float(sourceFootprint.height) / float(destination.height)}
+		};
+
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pyramidPipelineLayout, 0, 1, &pyramidSets[level], 0, nullptr);
+		cmd.pushConstants(pyramidPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PyramidConstants), &constants);
+		cmd.dispatch((destination.width + 7) / 8, (destination.height + 7) / 8, 1);
+
+		levelBarrier.subresourceRange.baseMipLevel = level;
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+
+		source = destination;
+		sourceFootprint = destination;
+	}
+
+	pyramidValid = true;
+}
+
+void GpuCuller::_createPyramid(RenderTexture* depthTexture, vk::Extent2D extent) {
+	pyramidSource = depthTexture;
+	pyramidVersion = renderContext->surfaceVersion;
+	depthExtent = extent;
+	pyramidInitialized = false;
+	pyramidValid = false;
+
+	// power of two levels halve exactly, so the texels under a uv cover the same area of the attachment on every
+	// level. rounded up odd sizes would drift away from it and could miss depth the box overlaps
+	pyramidLevelExtents.clear();
+	vk::Extent2D level{std::bit_floor(std::max(extent.width, 1u)), std::bit_floor(std::max(extent.height, 1u))};
+	while (pyramidLevelExtents.size() < MaxPyramidLevels) {
+		pyramidLevelExtents.emplace_back(level);
+		if (level.width == 1 && level.height == 1) {
+			break;
+		}
+		level = vk::Extent2D{std::max(level.width / 2, 1u), std::max(level.height / 2, 1u)};
+	}
+
+	const auto levelCount = uint32_t(pyramidLevelExtents.size());
+
+	VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{
+		.imageType = vk::ImageType::e2D,
+		.format = vk::Format::eR32Sfloat,
+		.extent = {
+			.width = pyramidLevelExtents.front().width,
+			.height = pyramidLevelExtents.front().height,
+			.depth = 1
+		},
+		.mipLevels = levelCount,
+		.arrayLayers = 1,
+		.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage
+	};
+
+	VmaAllocationCreateInfo allocationCreateInfo{.usage = VMA_MEMORY_USAGE_GPU_ONLY};
+	vmaCreateImage(core->allocator(), &imageCreateInfo, &allocationCreateInfo, &pyramidImage, &pyramidAllocation, nullptr);
+
+	pyramidView = core->device().createImageView({
+		.image = pyramidImage,
+		.viewType = vk::ImageViewType::e2D,
+		.format = vk::Format::eR32Sfloat,
+		.subresourceRange = {
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.levelCount = levelCount,
+			.layerCount = 1
+		}
+	});
+
+	pyramidLevelViews.resize(levelCount);
+	for (uint32_t i = 0; i < levelCount; i++) {
+		pyramidLevelViews[i] = core->device().createImageView({
+			.image = pyramidImage,
+			.viewType = vk::ImageViewType::e2D,
+			.format = vk::Format::eR32Sfloat,
+			.subresourceRange = {
+				.aspectMask = vk::ImageAspectFlagBits::eColor,
+				.baseMipLevel = i,
+				.levelCount = 1,
+				.layerCount = 1
+			}
+		});
+	}
+
+	_updateDescriptors();
+}
+
+void GpuCuller::_destroyPyramid() {
+	auto device = core->device();
+
+	for (auto view : pyramidLevelViews) {
+		device.destroyImageView(view, nullptr);
+	}
+	pyramidLevelViews.clear();
+
+	if (pyramidView) {
+		device.destroyImageView(pyramidView, nullptr);
+		pyramidView = nullptr;
+	}
+	if (pyramidImage) {
+		vmaDestroyImage(core->allocator(), pyramidImage, pyramidAllocation);
+		pyramidImage = nullptr;
+		pyramidAllocation = nullptr;
+	}
+	pyramidSource = nullptr;
+}
+
+void GpuCuller::_updateDescriptors() {
+	std::vector<vk::DescriptorImageInfo> imageInfos;
+	std::vector<vk::WriteDescriptorSet> writes;
+	imageInfos.reserve(RenderContext::MaxFramesInFlight + pyramidLevelViews.size() * 2);
+
+	for (auto& frame : frames) {
+		auto& info = imageInfos.emplace_back(vk::DescriptorImageInfo{
+			.sampler = sampler,
+			.imageView = pyramidView,
+			.imageLayout = vk::ImageLayout::eGeneral
+		});
+		writes.emplace_back(vk::WriteDescriptorSet{
+			.dstSet = frame.descriptorSet,
+			.dstBinding = 4,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+			.pImageInfo = &info
+		});
+	}
+
+	for (uint32_t level = 0; level < uint32_t(pyramidLevelViews.size()); level++) {
+		auto& source = imageInfos.emplace_back(vk::DescriptorImageInfo{
+			.sampler = sampler,
+			.imageView = level == 0 ? vk::ImageView(pyramidSource->view) : pyramidLevelViews[level - 1],
+			.imageLayout = level == 0 ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::eGeneral
+		});
+		auto& destination = imageInfos.emplace_back(vk::DescriptorImageInfo{
+			.imageView = pyramidLevelViews[level],
+			.imageLayout = vk::ImageLayout::eGeneral
+		});
+
+		writes.emplace_back(vk::WriteDescriptorSet{
+			.dstSet = pyramidSets[level],
+			.dstBinding = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+			.pImageInfo = &source
+		});
+		writes.emplace_back(vk::WriteDescriptorSet{
+			.dstSet = pyramidSets[level],
+			.dstBinding = 1,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eStorageImage,
+			.pImageInfo = &destination
+		});
+	}
+
+	core->device().updateDescriptorSets(uint32_t(writes.size()), writes.data(), 0, nullptr);
+}
+
+vk::ShaderModule GpuCuller::_loadShader(Handle<AppPlatform> platform, const std::string& path) {
+	auto bytes = platform->readAssetFile(path);
+
+	vk::ShaderModuleCreateInfo shaderModuleCreateInfo {
+		.codeSize = bytes.size(),
+		.pCode = reinterpret_cast<const uint32_t *>(bytes.data())
+	};
+	return core->device().createShaderModule(shaderModuleCreateInfo);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "client/renderer/RenderContext.hpp"
+#include "client/AppPlatform.hpp"
+#include "client/util/Handle.hpp"
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+// matches the std430 layout read by cull.comp
+struct GpuDrawBounds {
+	glm::vec4 minimum;
+	glm::vec4 maximum;
+};
+
+// compute pass that tests every draw's bounds against the frustum and a depth pyramid of the previous frame,
+// surviving commands are compacted into an indirect buffer drawn with a single drawIndexedIndirectCount.
+// the pass is recorded by the render context's before/after render pass hooks
+struct GpuCuller {
+	inline static constexpr uint32_t MaxDraws = 16384;
+	inline static constexpr uint32_t MaxPyramidLevels = 16;
+
+	void create(Handle<AppPlatform> platform, Handle<RenderContext> context);
+	void destroy();
+
+	// stored until the next frame starts recording, commands and bounds are matched by index
+	void setDraws(std::span<const GpuDrawBounds> bounds, std::span<const vk::DrawIndexedIndirectCommand> commands);
+	void setViewProjection(const glm::mat4& matrix);
+
+	// records the compacted draws of the current frame, the caller binds the pipeline and buffers they share
+	void draw(vk::CommandBuffer cmd);
+
+	bool enabled = false;
+
+private:
+	struct FrameBuffers {
+		Buffer bounds;
+		Buffer commands;
+		Buffer visibleCommands;
+		Buffer visibleCount;
+		Buffer view;
+		void* mappedBounds;
+		void* mappedCommands;
+		void* mappedView;
+		vk::DescriptorSet descriptorSet;
+	};
+
+	void _cull(vk::CommandBuffer cmd);
+	void _buildPyramid(vk::CommandBuffer cmd);
+
+	void _createPyramid(RenderTexture* depthTexture, vk::Extent2D extent);
+	void _destroyPyramid();
+	void _updateDescriptors();
+
+	vk::ShaderModule _loadShader(Handle<AppPlatform> platform, const std::string& path);
+
+	RenderSystem* core = RenderSystem::Instance();
+	RenderContext* renderContext{nullptr};
+
+	vk::DescriptorPool descriptorPool;
+	vk::DescriptorSetLayout cullSetLayout;
+	vk::DescriptorSetLayout pyramidSetLayout;
+	vk::PipelineLayout cullPipelineLayout;
+	vk::PipelineLayout pyramidPipelineLayout;
+	vk::Pipeline cullPipeline;
+	vk::Pipeline pyramidPipeline;
+	vk::Sampler sampler;
+
+	FrameBuffers frames[RenderContext::MaxFramesInFlight];
+
+	// the pyramid follows the depth attachment, it is rebuilt when the attachment is replaced
+	RenderTexture* pyramidSource{nullptr};
+	// the depth texture can be recreated at the same address, the version tells them apart
+	uint32_t pyramidVersion{0};
+	VkImage pyramidImage{nullptr};
+	VmaAllocation pyramidAllocation{nullptr};
+	vk::ImageView pyramidView;
+	std::vector<vk::ImageView> pyramidLevelViews;
+	std::vector<vk::Extent2D> pyramidLevelExtents;
+	vk::DescriptorSet pyramidSets[MaxPyramidLevels];
+	vk::Extent2D depthExtent;
+	// the part of the pyramid written from the last frame's render area
+	glm::vec2 pyramidScale{1.0f};
+	// the camera the pyramid's depth was rendered with, boxes are projected with it for the occlusion test
+	glm::mat4 pyramidViewProjection{1.0f};
+	bool pyramidInitialized = false;
+	bool pyramidValid = false;
+
+	std::vector<GpuDrawBounds> pendingBounds;
+	std::vector<vk::DrawIndexedIndirectCommand> pendingCommands;
+	glm::mat4 viewProjection{1.0f};
+	uint32_t drawCount = 0;
+};
@@ -0,0 +1,180 @@
+#include "OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VCRAFT_OCCLUSION_SSE2 1
+#endif
+
+void OcclusionCuller::begin(const glm::mat4& matrix) {
+	viewProjection = matrix;
+	occluderTriangles = 0;
+
+	depth.assign(size_t(Width) * Height, std::numeric_limits<float>::max());
+}
+
+void OcclusionCuller::addOccluderQuad(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3) {
+	// quads touching the near plane are skipped, dropping an occluder is always safe
+	ScreenVertex v[4];
+	if (!_project(p0, v[0]) || !_project(p1, v[1]) || !_project(p2, v[2]) || !_project(p3, v[3])) {
+		return;
+	}
+
+	_rasterizeTriangle(v[0], v[1], v[2]);
+	_rasterizeTriangle(v[0], v[2], v[3]);
+}
+
+void OcclusionCuller::addOccluder(const AABB& box) {
+	const glm::vec3 c[8] {
+		{box.minX, box.minY, box.minZ},
+		{box.maxX, box.minY, box.minZ},
+		{box.maxX, box.maxY, box.minZ},
+		{box.minX, box.maxY, box.minZ},
+		{box.minX, box.minY, box.maxZ},
+		{box.maxX, box.minY, box.maxZ},
+		{box.maxX, box.maxY, box.maxZ},
+		{box.minX, box.maxY, box.maxZ}
+	};
+
+	addOccluderQuad(c[0], c[1], c[2], c[3]);
+	addOccluderQuad(c[5], c[4], c[7], c[6]);
+	addOccluderQuad(c[4], c[0], c[3], c[7]);
+	addOccluderQuad(c[1], c[5], c[6], c[2]);
+	addOccluderQuad(c[3], c[2], c[6], c[7]);
+	addOccluderQuad(c[4], c[5], c[1], c[0]);
+}
+
+bool OcclusionCuller::isVisible(const AABB& box) const {
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxY = std::numeric_limits<float>::lowest();
+	float nearestW = std::numeric_limits<float>::max();
+
+	for (int i = 0; i < 8; i++) {
+		const glm::vec3 corner{
+			(i & 1) ? box.maxX : box.minX,
+			(i & 2) ? box.maxY : box.minY,
+			(i & 4) ? box.maxZ : box.minZ
+		};
+
+		ScreenVertex v;
+		if (!_project(corner, v)) {
+			return true;
+		}
+
+		minX = std::min(minX, v.x);
+		minY = std::min(minY, v.y);
+		maxX = std::max(maxX, v.x);
+		maxY = std::max(maxY, v.y);
+		nearestW = std::min(nearestW, v.w);
+	}
+
+	const int x0 = std::max(int(std::floor(minX)), 0);
+	const int y0 = std::max(int(std::floor(minY)), 0);
+	const int x1 = std::min(int(std::ceil(maxX)), Width);
+	const int y1 = std::min(int(std::ceil(maxY)), Height);
+	if (x0 >= x1 || y0 >= y1) {
+		return true;
+	}
+
+	// visible as soon as one covered texel has no occluder in front of the nearest corner,
+	// rows are tested in aligned groups of four and the extra texels only make the test more conservative
+	for (int y = y0; y < y1; y++) {
+		auto row = depth.data() + size_t(y) * Width;
+
+#if VCRAFT_OCCLUSION_SSE2
+		const __m128 w = _mm_set1_ps(nearestW);
+		for (int x = x0 & ~3; x < x1; x += 4) {
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), w)) != 0) {
+				return true;
+			}
+		}
+#else
+		for (int x = x0; x < x1; x++) {
+			if (row[x] >= nearestW) {
+				return true;
+			}
+		}
+#endif
+	}
+	return false;
+}
+
+bool OcclusionCuller::_project(const glm::vec3& position, ScreenVertex& out) const {
+	auto clip = viewProjection * glm::vec4(position, 1.0f);
+	if (clip.w < NearW) {
+		return false;
+	}
+
+	out.x = (clip.x / clip.w * 0.5f + 0.5f) * float(Width);
+	out.y = (clip.y / clip.w * 0.5f + 0.5f) * float(Height);
+	out.w = clip.w;
+	return true;
+}
+
+void OcclusionCuller::_rasterizeTriangle(ScreenVertex a, ScreenVertex b, ScreenVertex c) {
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (std::abs(area) < 1e-6f) {
+		return;
+	}
+	if (area < 0.0f) {
+		std::swap(b, c);
+	}
+
+	const int x0 = std::max(int(std::floor(std::min({a.x, b.x, c.x}))), 0);
+	const int y0 = std::max(int(std::floor(std::min({a.y, b.y, c.y}))), 0);
+	const int x1 = std::min(int(std::ceil(std::max({a.x, b.x, c.x}))), Width);
+	const int y1 = std::min(int(std::ceil(std::max({a.y, b.y, c.y}))), Height);
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	occluderTriangles++;
+
+	const float triangleW = std::max({a.w, b.w, c.w});
+
+	// edge function e(x, y) = A * x + B * y + C, positive inside for counter clockwise triangles
+	const ScreenVertex* vertices[3] {&a, &b, &c};
+	float A[3], B[3], C[3];
+	for (int i = 0; i < 3; i++) {
+		auto& p = *vertices[i];
+		auto& q = *vertices[(i + 1) % 3];
+		A[i] = p.y - q.y;
+		B[i] = q.x - p.x;
+		C[i] = p.x * q.y - p.y * q.x;
+	}
+
+	for (int y = y0; y < y1; y++) {
+		const float py = float(y) + 0.5f;
+		auto row = depth.data() + size_t(y) * Width;
+
+#if VCRAFT_OCCLUSION_SSE2
+		const __m128 w = _mm_set1_ps(triangleW);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+		for (int x = x0 & ~3; x < x1; x += 4) {
+			const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), offsets);
+
+			__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[0]), px), _mm_set1_ps(B[0] * py + C[0])), zero);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[1]), px), _mm_set1_ps(B[1] * py + C[1])), zero));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[2]), px), _mm_set1_ps(B[2] * py + C[2])), zero));
+
+			const __m128 current = _mm_loadu_ps(row + x);
+			const __m128 closer = _mm_min_ps(current, w);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, current)));
+		}
+#else
+		for (int x = x0; x < x1; x++) {
+			const float px = float(x) + 0.5f;
+			if (A[0] * px + B[0] * py + C[0] >= 0.0f && A[1] * px + B[1] * py + C[1] >= 0.0f && A[2] * px + B[2] * py + C[2] >= 0.0f) {
+				row[x] = std::min(row[x], triangleW);
+			}
+		}
+#endif
+	}
+}
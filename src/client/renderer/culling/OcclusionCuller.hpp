@@ -0,0 +1,42 @@
+#pragma once
+
+#include "util/math/AABB.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// low resolution software depth buffer. a few opaque occluders are rasterized into it every frame and
+// bounding boxes are tested against it before their draws are recorded, so nothing is read back from the gpu.
+// depth is the clip space w (view distance), occluder triangles are written at their farthest vertex so the
+// buffer never claims more occlusion than the real geometry provides
+struct OcclusionCuller {
+	inline static constexpr int Width = 256;
+	inline static constexpr int Height = 128;
+	inline static constexpr float NearW = 0.05f;
+
+	void begin(const glm::mat4& viewProjection);
+
+	// the quad must be fully opaque, corners are given in order around the quad
+	void addOccluderQuad(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3);
+	void addOccluder(const AABB& box);
+
+	// boxes crossing the near plane or leaving the screen are always reported visible
+	bool isVisible(const AABB& box) const;
+
+	uint32_t occluderTriangles = 0;
+
+private:
+	struct ScreenVertex {
+		float x;
+		float y;
+		float w;
+	};
+
+	bool _project(const glm::vec3& position, ScreenVertex& out) const;
+	void _rasterizeTriangle(ScreenVertex a, ScreenVertex b, ScreenVertex c);
+
+	glm::mat4 viewProjection{1.0f};
+	std::vector<float> depth;
+};
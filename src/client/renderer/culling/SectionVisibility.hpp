@@ -0,0 +1,213 @@
+#pragma once
+
+#include "util/math/TilePos.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+enum class SectionFace : uint8_t {
+	Down,	// -y
+	Up,		// +y
+	North,	// -z
+	South,	// +z
+	West,	// -x
+	East	// +x
+};
+
+// which pairs of a 16x16x16 section's faces are connected through non-opaque cells,
+// one bit per unordered pair of the six faces (15 bits)
+struct SectionConnectivity {
+	inline static constexpr int Size = 16;
+	inline static constexpr int CellCount = Size * Size * Size;
+	inline static constexpr uint16_t AllConnected = 0x7FFF;
+
+	// cells are indexed (y * 16 + z) * 16 + x
+	using OpacityMask = std::bitset<CellCount>;
+
+	uint16_t mask = AllConnected;
+
+	static constexpr int pairIndex(SectionFace a, SectionFace b) {
+		auto i = int(a);
+		auto j = int(b);
+		if (i > j) {
+			std::swap(i, j);
+		}
+		// rows of the upper triangle of the 6x6 face matrix, without its diagonal
+		return i * 5 - i * (i - 1) / 2 + (j - i - 1);
+	}
+
+	bool connected(SectionFace a, SectionFace b) const {
+		return a == b || (mask & (1u << pairIndex(a, b))) != 0;
+	}
+
+	// flood fills every open region once and connects all faces the region touches, called when a section is meshed
+	static SectionConnectivity compute(const OpacityMask& opaque) {
+		const auto opaqueCount = opaque.count();
+
+		// a wall separating two faces needs at least one full 16x16 layer of opaque cells
+		if (opaqueCount < size_t(Size * Size)) {
+			return {AllConnected};
+		}
+		if (opaqueCount == size_t(CellCount)) {
+			return {0};
+		}
+
+		SectionConnectivity result{0};
+
+		OpacityMask visited = opaque;
+		std::vector<uint16_t> stack;
+		stack.reserve(CellCount);
+
+		for (int start = 0; start < CellCount; start++) {
+			if (visited[start]) {
+				continue;
+			}
+
+			uint8_t faces = 0;
+			visited[start] = true;
+			stack.push_back(uint16_t(start));
+
+			while (!stack.empty()) {
+				const int cell = stack.back();
+				stack.pop_back();
+
+				const int x = cell & 15;
+				const int z = (cell >> 4) & 15;
+				const int y = cell >> 8;
+
+				faces |= _touchedFaces(x, y, z);
+
+				const int neighbours[6][2] {
+					{x > 0, cell - 1},
+					{x < 15, cell + 1},
+					{z > 0, cell - 16},
+					{z < 15, cell + 16},
+					{y > 0, cell - 256},
+					{y < 15, cell + 256}
+				};
+				for (auto& [valid, next] : neighbours) {
+					if (valid && !visited[next]) {
+						visited[next] = true;
+						stack.push_back(uint16_t(next));
+					}
+				}
+			}
+
+			for (int a = 0; a < 6; a++) {
+				for (int b = a + 1; b < 6; b++) {
+					if ((faces & (1u << a)) && (faces & (1u << b))) {
+						result.mask |= uint16_t(1u << pairIndex(SectionFace(a), SectionFace(b)));
+					}
+				}
+			}
+
+			if (result.mask == AllConnected) {
+				break;
+			}
+		}
+		return result;
+	}
+
+private:
+	static uint8_t _touchedFaces(int x, int y, int z) {
+		uint8_t faces = 0;
+		faces |= uint8_t(y == 0) << int(SectionFace::Down);
+		faces |= uint8_t(y == 15) << int(SectionFace::Up);
+		faces |= uint8_t(z == 0) << int(SectionFace::North);
+		faces |= uint8_t(z == 15) << int(SectionFace::South);
+		faces |= uint8_t(x == 0) << int(SectionFace::West);
+		faces |= uint8_t(x == 15) << int(SectionFace::East);
+		return faces;
+	}
+};
+
+// breadth first search from the camera's section through connected faces, sections that no path of
+// connected faces reaches cannot be seen and are dropped before any frustum test runs.
+// section positions are in section units
+struct SectionVisibility {
+	inline static constexpr std::array<TilePos, 6> Offsets {
+		TilePos{0, -1, 0},
+		TilePos{0, 1, 0},
+		TilePos{0, 0, -1},
+		TilePos{0, 0, 1},
+		TilePos{-1, 0, 0},
+		TilePos{1, 0, 0}
+	};
+
+	static constexpr SectionFace opposite(SectionFace face) {
+		return SectionFace(int(face) ^ 1);
+	}
+
+	// lookup(TilePos) returns the section's connectivity or nullptr when it is not loaded,
+	// visible receives the reached sections in front to back order
+	template <typename Lookup>
+	static void search(const TilePos& origin, int radius, Lookup&& lookup, std::vector<TilePos>& visible) {
+		struct Node {
+			TilePos position;
+			SectionFace entry;
+			uint8_t directions;	// faces already travelled through, the search never turns back along them
+			bool root;
+		};
+
+		const int diameter = radius * 2 + 1;
+		std::vector<bool> reached(size_t(diameter) * diameter * diameter, false);
+
+		auto index = [&](const TilePos& p) -> int {
+			const int x = p.x - origin.x + radius;
+			const int y = p.y - origin.y + radius;
+			const int z = p.z - origin.z + radius;
+			if (x < 0 || y < 0 || z < 0 || x >= diameter || y >= diameter || z >= diameter) {
+				return -1;
+			}
+			return (y * diameter + z) * diameter + x;
+		};
+
+		visible.clear();
+
+		if (lookup(origin) == nullptr) {
+			return;
+		}
+
+		std::deque<Node> queue;
+		queue.push_back(Node{origin, SectionFace::Down, 0, true});
+		reached[size_t(index(origin))] = true;
+
+		while (!queue.empty()) {
+			auto node = queue.front();
+			queue.pop_front();
+
+			visible.push_back(node.position);
+
+			const SectionConnectivity* connectivity = lookup(node.position);
+
+			for (int face = 0; face < 6; face++) {
+				const auto exit = SectionFace(face);
+
+				if (node.directions & (1u << int(opposite(exit)))) {
+					continue;
+				}
+				if (!node.root && !connectivity->connected(node.entry, exit)) {
+					continue;
+				}
+
+				const TilePos next{
+					node.position.x + Offsets[face].x,
+					node.position.y + Offsets[face].y,
+					node.position.z + Offsets[face].z
+				};
+
+				const int nextIndex = index(next);
+				if (nextIndex < 0 || reached[size_t(nextIndex)] || lookup(next) == nullptr) {
+					continue;
+				}
+
+				reached[size_t(nextIndex)] = true;
+				queue.push_back(Node{next, opposite(exit), uint8_t(node.directions | (1u << face)), false});
+			}
+		}
+	}
+};
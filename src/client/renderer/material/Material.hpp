@@ -3,63 +3,56 @@
 #include "client/renderer/RenderSystem.hpp"
 #include "client/util/DescriptorPool.hpp"
 
+#include "MaterialDefinition.hpp"
+
+#include "client/renderer/RenderQueue.hpp"
+
 #include "client/renderer/texture/Texture.hpp"
 
 struct Material {
 	inline static constinit vk::PushConstantRange constants[] {
-		{vk::ShaderStageFlagBits::eVertex, 0, sizeof(CameraTransform)}
+		{vk::ShaderStageFlagBits::eVertex, 0, sizeof(CameraTransform)},
+		{vk::ShaderStageFlagBits::eFragment, sizeof(CameraTransform), sizeof(TextureConstants)}
 	};
 
 	RenderSystem* core = RenderSystem::Instance();
 
-	vk::Sampler sampler;
-
-	vk::DescriptorSetLayout descriptorSetLayout;
+	// textures are bound through the global bindless set, the index set here is the material's default
 	vk::DescriptorSet descriptorSet;
+	uint32_t textureIndex{BindlessTextures::InvalidIndex};
 
+	// shared with every material that resolved to the same pipeline state, owned by the material manager
 	vk::PipelineLayout pipelineLayout;
 	vk::Pipeline pipeline;
+	RenderLayer layer{RenderLayer::Opaque};
 
-	Material(Handle<RenderContext> renderContext, std::span<const vk::PipelineShaderStageCreateInfo> shaderStages) {
-		vk::SamplerCreateInfo samplerCreateInfo{
-			.magFilter = vk::Filter::eNearest,
-			.minFilter = vk::Filter::eNearest,
-			.mipmapMode = vk::SamplerMipmapMode::eNearest,
-			.addressModeU = vk::SamplerAddressMode::eRepeat,
-			.addressModeV = vk::SamplerAddressMode::eRepeat,
-			.addressModeW = vk::SamplerAddressMode::eRepeat,
-			.maxAnisotropy = 0,
-			.minLod = 0,
-			.maxLod = 0
-		};
-
-		sampler = core->device().createSampler(samplerCreateInfo, nullptr);
+	// same state drawn with per-instance data, null when the material's shaders have no instanced version
+	vk::PipelineLayout instancedPipelineLayout;
+	vk::Pipeline instancedPipeline;
 
-		vk::DescriptorSetLayoutBinding descriptorSetLayoutBinding{
-				.binding = 0,
-				.descriptorType = vk::DescriptorType::eCombinedImageSampler,
-				.descriptorCount = 1,
-				.stageFlags = vk::ShaderStageFlagBits::eFragment,
-				.pImmutableSamplers = &sampler
-		};
+	Material(Handle<RenderContext> renderContext, vk::PipelineLayout pipelineLayout, vk::Pipeline pipeline, RenderLayer layer)
+		: pipelineLayout(pipelineLayout), pipeline(pipeline), layer(layer) {
+		descriptorSet = renderContext->bindlessTextures.descriptorSet;
+	}
 
-		vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{
-				.bindingCount = 1,
-				.pBindings = &descriptorSetLayoutBinding
+	// instanced layouts add the instance buffer as set 1, push constants are the same for both
+	static vk::PipelineLayout createPipelineLayout(Handle<RenderContext> renderContext, bool instanced = false) {
+		vk::DescriptorSetLayout setLayouts[] {
+				renderContext->bindlessTextures.descriptorSetLayout,
+				renderContext->instanceBuffer.descriptorSetLayout
 		};
-		descriptorSetLayout = core->device().createDescriptorSetLayout(descriptorSetLayoutCreateInfo, nullptr);
-		descriptorSet = renderContext->descriptorPool.allocate(descriptorSetLayout);
-
-		/*-----------------------------------------------------------------------------------------------------------*/
 
 		vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo{
-				.setLayoutCount = 1,
-				.pSetLayouts = &descriptorSetLayout,
+				.setLayoutCount = instanced ? 2u : 1u,
+				.pSetLayouts = setLayouts,
 				.pushConstantRangeCount = std::size(constants),
 				.pPushConstantRanges = constants
 		};
-		pipelineLayout = core->device().createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
+		return RenderSystem::Instance()->device().createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
+	}
 
+	// the vertex layout is the one every renderer writes, only the fixed function state comes from the material
+	static vk::Pipeline createPipeline(Handle<RenderContext> renderContext, vk::PipelineLayout pipelineLayout, const PipelineState& state, std::span<const vk::PipelineShaderStageCreateInfo> shaderStages) {
 		vk::VertexInputBindingDescription bindings[] {
 				{0, sizeof(Vertex), vk::VertexInputRate::eVertex}
 		};
@@ -78,7 +71,7 @@ struct Material {
 		};
 
 		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState{
-				.topology = vk::PrimitiveTopology::eTriangleList,
+				.topology = state.topology,
 				.primitiveRestartEnable = false
 		};
 
@@ -91,31 +84,36 @@ struct Material {
 
 		vk::PipelineRasterizationStateCreateInfo rasterizationState{
 				.polygonMode = vk::PolygonMode::eFill,
-				.cullMode = vk::CullModeFlagBits::eBack,
+				.cullMode = state.cullMode,
 				.frontFace = vk::FrontFace::eClockwise,
+				.depthBiasEnable = state.depthBias != 0.0f || state.slopeScaledDepthBias != 0.0f,
+				.depthBiasConstantFactor = state.depthBias,
+				.depthBiasSlopeFactor = state.slopeScaledDepthBias,
 				.lineWidth = 1.0f
 		};
 
-		vk::PipelineMultisampleStateCreateInfo multisampleState {};
+		vk::PipelineMultisampleStateCreateInfo multisampleState {
+				.alphaToCoverageEnable = state.alphaToCoverage
+		};
 
 		vk::PipelineColorBlendAttachmentState colorBlendAttachmentState{
-				.blendEnable = VK_TRUE,
-				.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
-				.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+				.blendEnable = state.blending,
+				.srcColorBlendFactor = state.srcColorBlendFactor,
+				.dstColorBlendFactor = state.dstColorBlendFactor,
 				.colorBlendOp = vk::BlendOp::eAdd,
-				.srcAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
-				.dstAlphaBlendFactor = vk::BlendFactor::eZero,
+				.srcAlphaBlendFactor = state.srcAlphaBlendFactor,
+				.dstAlphaBlendFactor = state.dstAlphaBlendFactor,
 				.alphaBlendOp = vk::BlendOp::eAdd,
-				.colorWriteMask = vk::ColorComponentFlagBits::eR |
-						vk::ColorComponentFlagBits::eG |
-						vk::ColorComponentFlagBits::eB |
-						vk::ColorComponentFlagBits::eA
+				.colorWriteMask = state.colorWriteMask
 		};
 
 		vk::PipelineDepthStencilStateCreateInfo depthStencilState {
-			.depthTestEnable = VK_TRUE,
-			.depthWriteEnable = VK_TRUE,
-			.depthCompareOp = vk::CompareOp::eLess
+			.depthTestEnable = state.depthTest,
+			.depthWriteEnable = state.depthWrite,
+			.depthCompareOp = state.depthCompareOp,
+			.stencilTestEnable = state.stencilTest,
+			.front = state.front,
+			.back = state.back
 		};
 
 		vk::PipelineColorBlendStateCreateInfo colorBlendState{
@@ -148,32 +146,13 @@ struct Material {
 				.renderPass = renderContext->renderPass,
 		};
 
-		core->device().createGraphicsPipelines(nullptr, 1, &pipelineCreateInfo, nullptr, &pipeline);
+		vk::Pipeline pipeline;
+		RenderSystem::Instance()->device().createGraphicsPipelines(nullptr, 1, &pipelineCreateInfo, nullptr, &pipeline);
+		return pipeline;
 	}
 
 	void SetTexture(Texture* texture) {
-		vk::DescriptorImageInfo imageInfo{
-				.sampler = texture->renderTexture->sampler,
-				.imageView = texture->renderTexture->view,
-				.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
-		};
-
-		vk::WriteDescriptorSet writeDescriptorSet{
-				.dstSet = descriptorSet,
-				.dstBinding = 0,
-				.dstArrayElement = 0,
-				.descriptorCount = 1,
-				.descriptorType = vk::DescriptorType::eCombinedImageSampler,
-				.pImageInfo = &imageInfo,
-		};
-
-		core->device().updateDescriptorSets(1, &writeDescriptorSet, 0, nullptr);
-	}
-
-	void destroy() {
-		core->device().destroyDescriptorSetLayout(descriptorSetLayout, nullptr);
-		core->device().destroyPipelineLayout(pipelineLayout, nullptr);
-		core->device().destroyPipeline(pipeline, nullptr);
+		textureIndex = texture->renderTexture->bindlessIndex;
 	}
 
 private:
@@ -0,0 +1,307 @@
+#pragma once
+
+#include "client/renderer/RenderSystem.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+// fixed function state of a graphics pipeline, materials that resolve to the same state share one pipeline
+struct PipelineState {
+	std::string vertexShader;
+	std::string fragmentShader;
+	// reads per-instance data from set 1, see InstanceBuffer
+	bool instanced = false;
+
+	vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+	vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+
+	bool depthTest = true;
+	bool depthWrite = true;
+	vk::CompareOp depthCompareOp = vk::CompareOp::eLessOrEqual;
+	float depthBias = 0.0f;
+	float slopeScaledDepthBias = 0.0f;
+
+	bool blending = false;
+	vk::BlendFactor srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+	vk::BlendFactor dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+	vk::BlendFactor srcAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+	vk::BlendFactor dstAlphaBlendFactor = vk::BlendFactor::eZero;
+	vk::ColorComponentFlags colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+	bool alphaToCoverage = false;
+
+	bool stencilTest = false;
+	vk::StencilOpState front{.compareOp = vk::CompareOp::eAlways, .compareMask = 0xFF, .writeMask = 0xFF};
+	vk::StencilOpState back{.compareOp = vk::CompareOp::eAlways, .compareMask = 0xFF, .writeMask = 0xFF};
+
+	bool operator==(const PipelineState&) const = default;
+
+	struct Hash {
+		size_t operator()(const PipelineState& state) const {
+			return size_t(state.hash());
+		}
+	};
+
+	// fnv-1a over every field, the shader paths stand in for the modules loaded from them
+	uint64_t hash() const {
+		uint64_t value = 0xcbf29ce484222325ull;
+		auto mix = [&](const void* data, size_t size) {
+			auto bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++) {
+				value ^= bytes[i];
+				value *= 0x100000001b3ull;
+			}
+		};
+		auto mixValue = [&](const auto& field) {
+			mix(&field, sizeof(field));
+		};
+		// -0.0f compares equal to 0.0f, so both have to hash the same
+		auto mixFloat = [&](float field) {
+			mixValue(field == 0.0f ? 0.0f : field);
+		};
+
+		mix(vertexShader.data(), vertexShader.size() + 1);
+		mix(fragmentShader.data(), fragmentShader.size() + 1);
+		mixValue(instanced);
+		mixValue(topology);
+		mixValue(cullMode);
+		mixValue(depthTest);
+		mixValue(depthWrite);
+		mixValue(depthCompareOp);
+		mixFloat(depthBias);
+		mixFloat(slopeScaledDepthBias);
+		mixValue(blending);
+		mixValue(srcColorBlendFactor);
+		mixValue(dstColorBlendFactor);
+		mixValue(srcAlphaBlendFactor);
+		mixValue(dstAlphaBlendFactor);
+		mixValue(colorWriteMask);
+		mixValue(alphaToCoverage);
+		mixValue(stencilTest);
+		for (auto& face : {front, back}) {
+			mixValue(face.failOp);
+			mixValue(face.passOp);
+			mixValue(face.depthFailOp);
+			mixValue(face.compareOp);
+			mixValue(face.compareMask);
+			mixValue(face.writeMask);
+			mixValue(face.reference);
+		}
+		return value;
+	}
+};
+
+// one entry of a .material file after its parents were merged into it.
+// keys are "name" or "name:parent", plain fields replace the parent's value, +/- lists add to or remove from it
+struct MaterialDefinition {
+	std::string vertexShader;
+	std::string fragmentShader;
+	std::set<std::string> defines;
+	std::set<std::string> states;
+	std::vector<std::string> vertexFields;
+
+	std::string primitiveMode;
+	std::string depthFunc;
+	std::string blendSrc;
+	std::string blendDst;
+	std::string alphaSrc;
+	std::string alphaDst;
+	float depthBias = 0.0f;
+	float slopeScaledDepthBias = 0.0f;
+
+	int stencilRef = 0;
+	int stencilReadMask = 0xFF;
+	int stencilWriteMask = 0xFF;
+	nlohmann::json frontFace;
+	nlohmann::json backFace;
+
+	void apply(const nlohmann::json& object) {
+		_string(object, "vertexShader", vertexShader);
+		_string(object, "fragmentShader", fragmentShader);
+		_string(object, "primitiveMode", primitiveMode);
+		_string(object, "depthFunc", depthFunc);
+		_string(object, "blendSrc", blendSrc);
+		_string(object, "blendDst", blendDst);
+		_string(object, "alphaSrc", alphaSrc);
+		_string(object, "alphaDst", alphaDst);
+
+		_list(object, "defines", defines);
+		_list(object, "states", states);
+
+		if (auto it = object.find("vertexFields"); it != object.end()) {
+			vertexFields.clear();
+			for (auto& field : *it) {
+				vertexFields.emplace_back(field.at("field").get<std::string>());
+			}
+		}
+
+		_value(object, "depthBias", depthBias);
+		_value(object, "slopeScaledDepthBias", slopeScaledDepthBias);
+		_value(object, "stencilRef", stencilRef);
+		_value(object, "stencilReadMask", stencilReadMask);
+		_value(object, "stencilWriteMask", stencilWriteMask);
+
+		if (auto it = object.find("frontFace"); it != object.end()) {
+			frontFace = *it;
+		}
+		if (auto it = object.find("backFace"); it != object.end()) {
+			backFace = *it;
+		}
+	}
+
+	PipelineState pipelineState(std::string vertexModule, std::string fragmentModule) const {
+		PipelineState state{
+			.vertexShader = std::move(vertexModule),
+			.fragmentShader = std::move(fragmentModule)
+		};
+
+		if (primitiveMode == "Line") {
+			state.topology = vk::PrimitiveTopology::eLineStrip;
+		} else if (primitiveMode == "Lines") {
+			state.topology = vk::PrimitiveTopology::eLineList;
+		} else if (primitiveMode == "TriangleStrip") {
+			state.topology = vk::PrimitiveTopology::eTriangleStrip;
+		}
+
+		if (states.contains("DisableCulling")) {
+			state.cullMode = vk::CullModeFlagBits::eNone;
+		}
+
+		state.depthTest = !states.contains("DisableDepthTest");
+		state.depthWrite = !states.contains("DisableDepthWrite");
+		if (!depthFunc.empty()) {
+			state.depthCompareOp = _compareOp(depthFunc);
+		}
+		state.depthBias = depthBias;
+		state.slopeScaledDepthBias = slopeScaledDepthBias;
+
+		state.blending = states.contains("Blending");
+		if (state.blending) {
+			if (!blendSrc.empty()) {
+				state.srcColorBlendFactor = _blendFactor(blendSrc);
+			}
+			if (!blendDst.empty()) {
+				state.dstColorBlendFactor = _blendFactor(blendDst);
+			}
+			if (!alphaSrc.empty()) {
+				state.srcAlphaBlendFactor = _blendFactor(alphaSrc);
+			}
+			if (!alphaDst.empty()) {
+				state.dstAlphaBlendFactor = _blendFactor(alphaDst);
+			}
+		}
+
+		if (states.contains("DisableColorWrite")) {
+			state.colorWriteMask = {};
+		} else if (states.contains("DisableAlphaWrite")) {
+			state.colorWriteMask &= ~vk::ColorComponentFlags(vk::ColorComponentFlagBits::eA);
+		}
+		state.alphaToCoverage = states.contains("EnableAlphaToCoverage");
+
+		state.stencilTest = states.contains("EnableStencilTest");
+		if (state.stencilTest) {
+			state.front = _stencilFace(frontFace);
+			state.back = _stencilFace(backFace);
+		}
+		return state;
+	}
+
+private:
+	static void _string(const nlohmann::json& object, const char* key, std::string& out) {
+		if (auto it = object.find(key); it != object.end()) {
+			out = it->get<std::string>();
+		}
+	}
+
+	template <typename T>
+	static void _value(const nlohmann::json& object, const char* key, T& out) {
+		if (auto it = object.find(key); it != object.end()) {
+			out = it->get<T>();
+		}
+	}
+
+	static void _list(const nlohmann::json& object, const char* key, std::set<std::string>& out) {
+		const auto name = std::string(key);
+		if (auto it = object.find(name); it != object.end()) {
+			out.clear();
+			for (auto& value : *it) {
+				out.emplace(value.get<std::string>());
+			}
+		}
+		if (auto it = object.find("+" + name); it != object.end()) {
+			for (auto& value : *it) {
+				out.emplace(value.get<std::string>());
+			}
+		}
+		if (auto it = object.find("-" + name); it != object.end()) {
+			for (auto& value : *it) {
+				out.erase(value.get<std::string>());
+			}
+		}
+	}
+
+	vk::StencilOpState _stencilFace(const nlohmann::json& face) const {
+		vk::StencilOpState state{
+			.compareOp = vk::CompareOp::eAlways,
+			.compareMask = uint32_t(stencilReadMask),
+			.writeMask = uint32_t(stencilWriteMask),
+			.reference = uint32_t(stencilRef)
+		};
+		if (!face.is_object()) {
+			return state;
+		}
+
+		if (auto value = face.value("stencilFunc", std::string()); !value.empty()) {
+			state.compareOp = _compareOp(value);
+		}
+		// both spellings of the pass op appear in the vanilla files
+		for (auto key : {"stencilPassOp", "stencilPass"}) {
+			if (auto value = face.value(key, std::string()); !value.empty()) {
+				state.passOp = _stencilOp(value);
+			}
+		}
+		if (auto value = face.value("stencilFailOp", std::string()); !value.empty()) {
+			state.failOp = _stencilOp(value);
+		}
+		if (auto value = face.value("stencilDepthFailOp", std::string()); !value.empty()) {
+			state.depthFailOp = _stencilOp(value);
+		}
+		return state;
+	}
+
+	static vk::CompareOp _compareOp(std::string_view name) {
+		if (name == "Never") return vk::CompareOp::eNever;
+		if (name == "Less") return vk::CompareOp::eLess;
+		if (name == "Equal") return vk::CompareOp::eEqual;
+		if (name == "LessEqual") return vk::CompareOp::eLessOrEqual;
+		if (name == "Greater") return vk::CompareOp::eGreater;
+		if (name == "NotEqual") return vk::CompareOp::eNotEqual;
+		if (name == "GreaterEqual") return vk::CompareOp::eGreaterOrEqual;
+		return vk::CompareOp::eAlways;
+	}
+
+	static vk::StencilOp _stencilOp(std::string_view name) {
+		if (name == "Zero") return vk::StencilOp::eZero;
+		if (name == "Replace") return vk::StencilOp::eReplace;
+		if (name == "Increment") return vk::StencilOp::eIncrementAndClamp;
+		if (name == "Decrement") return vk::StencilOp::eDecrementAndClamp;
+		if (name == "Invert") return vk::StencilOp::eInvert;
+		return vk::StencilOp::eKeep;
+	}
+
+	static vk::BlendFactor _blendFactor(std::string_view name) {
+		if (name == "Zero") return vk::BlendFactor::eZero;
+		if (name == "One") return vk::BlendFactor::eOne;
+		if (name == "SourceColor") return vk::BlendFactor::eSrcColor;
+		if (name == "OneMinusSrcColor") return vk::BlendFactor::eOneMinusSrcColor;
+		if (name == "SourceAlpha") return vk::BlendFactor::eSrcAlpha;
+		if (name == "OneMinusSrcAlpha") return vk::BlendFactor::eOneMinusSrcAlpha;
+		if (name == "DestColor") return vk::BlendFactor::eDstColor;
+		if (name == "OneMinusDestColor") return vk::BlendFactor::eOneMinusDstColor;
+		if (name == "DestAlpha") return vk::BlendFactor::eDstAlpha;
+		if (name == "OneMinusDestAlpha") return vk::BlendFactor::eOneMinusDstAlpha;
+		return vk::BlendFactor::eOne;
+	}
+};
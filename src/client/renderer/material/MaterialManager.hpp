@@ -3,50 +3,226 @@
 #include "client/AppPlatform.hpp"
 #include "client/renderer/RenderContext.hpp"
 #include "client/util/Handle.hpp"
+#include "resources/ResourceManager.hpp"
 
 #include "Material.hpp"
+#include "MaterialDefinition.hpp"
 
 #include "nlohmann/json.hpp"
 
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <unordered_map>
+
 using Json = nlohmann::json;
 
 struct MaterialManager {
+	// a file listed again by a later list only picks up that list's defines
+	inline static constexpr const char* MaterialLists[] {
+		"materials/common.json",
+		"materials/fancy.json"
+	};
+
 	MaterialManager() {}
 
-	void loadMetaFile(Handle<AppPlatform> platform, Handle<RenderContext> renderContext) {
-		std::string_view bytes = R"({
-			"entity_static": {
-				"fragmentShader": "shaders/entity.frag.spv",
-				"vertexShader": "shaders/entity.vert.spv"
+	~MaterialManager() {
+		for (auto& [state, pipeline] : pipelines) {
+			core->device().destroyPipeline(pipeline, nullptr);
+		}
+		if (pipelineLayout) {
+			core->device().destroyPipelineLayout(pipelineLayout, nullptr);
+		}
+		if (instancedPipelineLayout) {
+			core->device().destroyPipelineLayout(instancedPipelineLayout, nullptr);
+		}
+	}
+
+	// materials whose shaders have no compiled spir-v or that need vertex fields the renderers don't write are
+	// resolved but not created
+	void loadMetaFile(Handle<ResourceManager> resourceManager, Handle<AppPlatform> platform, Handle<RenderContext> renderContext) {
+		for (auto list : MaterialLists) {
+			auto bytes = resourceManager->viewFile(list);
+			if (!bytes) {
+				continue;
+			}
+			for (auto& entry : Json::parse(bytes->begin(), bytes->end())) {
+				auto path = entry.at("path").get<std::string>();
+				auto defines = entry.value("+defines", std::vector<std::string>{});
+
+				auto it = std::find_if(files.begin(), files.end(), [&](auto& file) { return file.first == path; });
+				if (it == files.end()) {
+					files.emplace_back(path, std::set<std::string>(defines.begin(), defines.end()));
+				} else {
+					it->second.insert(defines.begin(), defines.end());
+				}
+			}
+		}
+
+		for (auto& [path, defines] : files) {
+			if (auto bytes = resourceManager->viewFile(path)) {
+				_parseMaterialFile(Json::parse(bytes->begin(), bytes->end(), nullptr, true, true), defines);
 			}
-		})";
+		}
 
-		auto obj = Json::parse(bytes);
-		for (auto& [name, define_material] : obj.items()) {
-			auto vertexShader = createShader(platform, define_material.at("vertexShader").get<std::string>());
-			auto fragmentShader = createShader(platform, define_material.at("fragmentShader").get<std::string>());
+		pipelineLayout = Material::createPipelineLayout(renderContext);
+		instancedPipelineLayout = Material::createPipelineLayout(renderContext, true);
 
-			vk::PipelineShaderStageCreateInfo stages[] {
-					{.stage = vk::ShaderStageFlagBits::eVertex, .module = vertexShader, .pName = "main"},
-					{.stage = vk::ShaderStageFlagBits::eFragment, .module = fragmentShader, .pName = "main"},
-			};
+		std::map<std::string, vk::ShaderModule> shaderModules;
+		for (auto& [name, source] : sources) {
+			auto& definition = _resolve(name);
+			if (!_matchesVertexLayout(definition)) {
+				continue;
+			}
 
-			materials.emplace(name, new Material(renderContext, stages));
+			auto pipeline = _getPipeline(platform, renderContext, shaderModules, definition, false);
+			if (!pipeline) {
+				continue;
+			}
 
-			core->device().destroyShaderModule(vertexShader, nullptr);
-			core->device().destroyShaderModule(fragmentShader, nullptr);
+			auto layer = _layer(definition);
+			auto& material = materials.emplace(name, std::make_unique<Material>(renderContext, pipelineLayout, pipeline, layer)).first->second;
+
+			if (auto instancedPipeline = _getPipeline(platform, renderContext, shaderModules, definition, true)) {
+				material->instancedPipelineLayout = instancedPipelineLayout;
+				material->instancedPipeline = instancedPipeline;
+			}
+		}
+
+		for (auto& [path, module] : shaderModules) {
+			if (module) {
+				core->device().destroyShaderModule(module, nullptr);
+			}
 		}
+
+		files.clear();
+		sources.clear();
+		definitions.clear();
 	}
 
 	Handle<Material> getMaterial(const std::string& name) {
 		return Handle(materials.at(name));
 	}
 
+	size_t materialCount() const {
+		return materials.size();
+	}
+
+	size_t pipelineCount() const {
+		return pipelines.size();
+	}
+
 private:
+	struct MaterialSource {
+		std::string parent;
+		Json object;
+		std::set<std::string> defines;
+	};
+
 	RenderSystem* core = RenderSystem::Instance();
 
+	// sky.material lists its materials at the top level instead of under "materials"
+	void _parseMaterialFile(const Json& file, const std::set<std::string>& defines) {
+		auto& entries = file.contains("materials") ? file.at("materials") : file;
+		for (auto& [key, object] : entries.items()) {
+			if (!object.is_object()) {
+				continue;
+			}
+
+			auto separator = key.find(':');
+			auto name = key.substr(0, separator);
+			auto parent = separator != std::string::npos ? key.substr(separator + 1) : std::string();
+
+			sources.insert_or_assign(name, MaterialSource{std::move(parent), object, defines});
+		}
+	}
+
+	// parents are resolved first and memoized, a missing parent or a cycle ends the chain there
+	const MaterialDefinition& _resolve(const std::string& name) {
+		if (auto it = definitions.find(name); it != definitions.end()) {
+			return it->second;
+		}
+
+		MaterialDefinition definition;
+
+		auto& source = sources.at(name);
+		if (!source.parent.empty() && sources.contains(source.parent) && resolving.insert(name).second) {
+			definition = _resolve(source.parent);
+			resolving.erase(name);
+		}
+
+		definition.defines.insert(source.defines.begin(), source.defines.end());
+		definition.apply(source.object);
+
+		return definitions.insert_or_assign(name, std::move(definition)).first->second;
+	}
+
+	// returns the pipeline shared by every material with the same state, null when a shader is missing
+	vk::Pipeline _getPipeline(Handle<AppPlatform> platform, Handle<RenderContext> renderContext, std::map<std::string, vk::ShaderModule>& shaderModules, const MaterialDefinition& definition, bool instanced) {
+		auto vertexPath = _shaderPath(definition.vertexShader, instanced ? "_instanced.vert.spv" : ".vert.spv");
+		auto fragmentPath = _shaderPath(definition.fragmentShader, instanced ? "_instanced.frag.spv" : ".frag.spv");
+
+		auto vertexShader = _getShader(platform, shaderModules, vertexPath);
+		auto fragmentShader = _getShader(platform, shaderModules, fragmentPath);
+		if (!vertexShader || !fragmentShader) {
+			return nullptr;
+		}
+
+		auto state = definition.pipelineState(vertexPath, fragmentPath);
+		state.instanced = instanced;
+
+		auto [it, inserted] = pipelines.try_emplace(std::move(state));
+		if (inserted) {
+			vk::PipelineShaderStageCreateInfo stages[] {
+					{.stage = vk::ShaderStageFlagBits::eVertex, .module = vertexShader, .pName = "main"},
+					{.stage = vk::ShaderStageFlagBits::eFragment, .module = fragmentShader, .pName = "main"},
+			};
+			it->second = Material::createPipeline(renderContext, instanced ? instancedPipelineLayout : pipelineLayout, it->first, stages);
+		}
+		return it->second;
+	}
+
+	static RenderLayer _layer(const MaterialDefinition& definition) {
+		if (definition.states.contains("Blending")) {
+			return RenderLayer::Translucent;
+		}
+		if (definition.defines.contains("ALPHA_TEST")) {
+			return RenderLayer::AlphaTest;
+		}
+		return RenderLayer::Opaque;
+	}
+
+	// the renderers write position, normal and uv0, see Material::createPipeline
+	static bool _matchesVertexLayout(const MaterialDefinition& definition) {
+		return std::all_of(definition.vertexFields.begin(), definition.vertexFields.end(), [](auto& field) {
+			return field == "Position" || field == "Normal" || field == "UV0";
+		});
+	}
+
+	// "shaders/entity.vertex" is compiled to "shaders/entity.vert.spv", its instanced version to "shaders/entity_instanced.vert.spv"
+	static std::string _shaderPath(const std::string& shader, const char* suffix) {
+		if (shader.empty()) {
+			return {};
+		}
+		return std::filesystem::path(shader).replace_extension().generic_string() + suffix;
+	}
+
+	vk::ShaderModule _getShader(Handle<AppPlatform> platform, std::map<std::string, vk::ShaderModule>& shaderModules, const std::string& path) {
+		if (path.empty()) {
+			return nullptr;
+		}
+		if (auto it = shaderModules.find(path); it != shaderModules.end()) {
+			return it->second;
+		}
+		return shaderModules.emplace(path, createShader(platform, path)).first->second;
+	}
+
 	inline vk::ShaderModule createShader(Handle<AppPlatform> platform, const std::string& path) {
 		auto bytes = platform->readAssetFile(path);
+		if (bytes.empty()) {
+			return nullptr;
+		}
 
 		vk::ShaderModuleCreateInfo shaderModuleCreateInfo {
 			.codeSize = bytes.size(),
@@ -56,5 +232,13 @@ private:
 		return core->device().createShaderModule(shaderModuleCreateInfo);
 	}
 
+	std::vector<std::pair<std::string, std::set<std::string>>> files;
+	std::map<std::string, MaterialSource> sources;
+	std::map<std::string, MaterialDefinition> definitions;
+	std::set<std::string> resolving;
+
+	vk::PipelineLayout pipelineLayout;
+	vk::PipelineLayout instancedPipelineLayout;
+	std::unordered_map<PipelineState, vk::Pipeline, PipelineState::Hash> pipelines;
 	std::map<std::string, std::unique_ptr<Material>> materials;
-};
\ No newline at end of file
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "client/renderer/TextureUVCoordinateSet.hpp"
+#include "resources/AssetView.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// a finished texture atlas stored on disk, so warm launches skip decoding and packing its sprites.
+// one file per atlas holding the key of the sources it was built from:
+// header | sprites | items | rgba8 sheet starting on an Alignment boundary
+struct AtlasCache {
+	inline static constexpr uint32_t Magic = 0x4c544156; // "VATL"
+	inline static constexpr uint32_t Version = 1;
+	inline static constexpr uint64_t Alignment = 16;
+
+	struct Sprite {
+		std::string path;
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	struct Item {
+		std::string name;
+		std::vector<TextureUVCoordinateSet> textures;
+	};
+
+	struct Entry {
+		uint32_t width;
+		uint32_t height;
+		std::vector<Sprite> sprites;
+		std::vector<Item> items;
+		// a view into the mapped file, the sheet is only paged in when it is read
+		AssetView pixels;
+	};
+
+	explicit AtlasCache(std::filesystem::path directory) : directory(std::move(directory)) {
+		std::error_code ec;
+		std::filesystem::create_directories(this->directory, ec);
+	}
+
+	// nothing when there is no entry for name, it was built from different sources or it is damaged
+	std::optional<Entry> load(const std::string& name, uint64_t key) const {
+		auto file = AssetView::map(_path(name));
+		if (!file || file.size() < sizeof(Header)) {
+			return std::nullopt;
+		}
+
+		Header header;
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (header.magic != Magic || header.version != Version || header.key != key) {
+			return std::nullopt;
+		}
+		if (header.pixelsOffset < sizeof(Header) || header.pixelsOffset > file.size() || header.pixelBytes != uint64_t(header.width) * header.height * 4 || header.pixelBytes > file.size() - header.pixelsOffset) {
+			return std::nullopt;
+		}
+
+		Reader reader{file.data() + sizeof(Header), file.data() + header.pixelsOffset};
+
+		// every sprite and item takes at least its fixed fields, so damaged counts are caught before allocating
+		if (header.spriteCount > reader.remaining() / (sizeof(int32_t) * 4 + sizeof(uint32_t)) || header.itemCount > reader.remaining() / (sizeof(uint32_t) * 2)) {
+			return std::nullopt;
+		}
+
+		Entry entry{.width = header.width, .height = header.height};
+
+		entry.sprites.resize(header.spriteCount);
+		for (auto& sprite : entry.sprites) {
+			int32_t rect[4];
+			if (!reader.read(rect, sizeof(rect)) || !reader.readString(sprite.path)) {
+				return std::nullopt;
+			}
+			sprite.x = rect[0];
+			sprite.y = rect[1];
+			sprite.width = rect[2];
+			sprite.height = rect[3];
+		}
+
+		entry.items.resize(header.itemCount);
+		for (auto& item : entry.items) {
+			uint32_t count;
+			if (!reader.readString(item.name) || !reader.read(&count, sizeof(count)) || count > reader.remaining() / sizeof(TextureUVCoordinateSet)) {
+				return std::nullopt;
+			}
+			item.textures.resize(count);
+			if (!reader.read(item.textures.data(), sizeof(TextureUVCoordinateSet) * count)) {
+				return std::nullopt;
+			}
+		}
+
+		entry.pixels = file.subview(header.pixelsOffset, header.pixelBytes);
+		return entry;
+	}
+
+	// written to a temporary file first, so a crash never leaves a truncated entry behind
+	void store(const std::string& name, uint64_t key, const Entry& entry, std::span<const uint8_t> pixels) const {
+		std::string body;
+		auto append = [&body](const void* data, size_t size) {
+			body.append(static_cast<const char*>(data), size);
+		};
+		auto appendString = [&](std::string_view value) {
+			auto length = uint32_t(value.size());
+			append(&length, sizeof(length));
+			append(value.data(), value.size());
+		};
+
+		for (auto& sprite : entry.sprites) {
+			int32_t rect[4] {sprite.x, sprite.y, sprite.width, sprite.height};
+			append(rect, sizeof(rect));
+			appendString(sprite.path);
+		}
+		for (auto& item : entry.items) {
+			auto count = uint32_t(item.textures.size());
+			appendString(item.name);
+			append(&count, sizeof(count));
+			append(item.textures.data(), sizeof(TextureUVCoordinateSet) * count);
+		}
+
+		const auto pixelsOffset = _align(sizeof(Header) + body.size());
+		body.resize(pixelsOffset - sizeof(Header), '\0');
+
+		Header header{
+			.magic = Magic,
+			.version = Version,
+			.key = key,
+			.width = entry.width,
+			.height = entry.height,
+			.spriteCount = uint32_t(entry.sprites.size()),
+			.itemCount = uint32_t(entry.items.size()),
+			.pixelsOffset = pixelsOffset,
+			.pixelBytes = pixels.size()
+		};
+
+		auto path = _path(name);
+		auto temp = std::filesystem::path(path).concat(".tmp");
+
+		{
+			std::ofstream ofs(temp, std::ios::binary);
+			if (!ofs) {
+				return;
+			}
+
+			ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			ofs.write(body.data(), std::streamsize(body.size()));
+			ofs.write(reinterpret_cast<const char*>(pixels.data()), std::streamsize(pixels.size()));
+			if (!ofs) {
+				return;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(temp, path, ec);
+	}
+
+private:
+	static_assert(std::is_trivially_copyable_v<TextureUVCoordinateSet>);
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t width;
+		uint32_t height;
+		uint32_t spriteCount;
+		uint32_t itemCount;
+		uint64_t pixelsOffset;
+		uint64_t pixelBytes;
+	};
+
+	struct Reader {
+		const char* it;
+		const char* end;
+
+		size_t remaining() const {
+			return size_t(end - it);
+		}
+
+		bool read(void* out, size_t size) {
+			if (remaining() < size) {
+				return false;
+			}
+			if (size != 0) {
+				std::memcpy(out, it, size);
+			}
+			it += size;
+			return true;
+		}
+
+		bool readString(std::string& out) {
+			uint32_t length;
+			if (!read(&length, sizeof(length)) || remaining() < length) {
+				return false;
+			}
+			out.assign(it, length);
+			it += length;
+			return true;
+		}
+	};
+
+	static uint64_t _align(uint64_t offset) {
+		return (offset + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	std::filesystem::path _path(const std::string& name) const {
+		return directory / (name + ".atlas");
+	}
+
+	std::filesystem::path directory;
+};
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "util/ThreadPool.hpp"
+
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum class BlockFormat : uint32_t {
+	BC1 = 1,
+	BC3 = 3,
+	BC7 = 7
+};
+
+// block compressed mip chain, levels keep their texel size and point into data
+struct CompressedImage {
+	BlockFormat format;
+	std::vector<uint8_t> data;
+	std::vector<MipLevel> levels;
+};
+
+// cpu encoder for bc1 (opaque), bc3 and bc7 (mode 6 only), blocks are split across the worker threads
+struct BlockEncoder {
+	static size_t blockSize(BlockFormat format) {
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	static bool hasAlpha(const uint8_t* rgba, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			if (rgba[i * 4 + 3] != 0xFF) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static CompressedImage encode(const MipChain& chain, BlockFormat format) {
+		CompressedImage image{.format = format};
+		image.levels.reserve(chain.levels.size());
+
+		size_t size = 0;
+		for (auto& level : chain.levels) {
+			image.levels.emplace_back(MipLevel{level.width, level.height, size});
+			size += size_t((level.width + 3) / 4) * ((level.height + 3) / 4) * blockSize(format);
+		}
+		image.data.resize(size);
+
+		for (size_t i = 0; i < chain.levels.size(); i++) {
+			auto& src = chain.levels[i];
+			auto& dst = image.levels[i];
+
+			const uint32_t blocksX = (src.width + 3) / 4;
+			const uint32_t blocksY = (src.height + 3) / 4;
+
+			ThreadPool::Instance()->parallel_for(blocksY, [&](size_t by) {
+				uint8_t block[64];
+				for (uint32_t bx = 0; bx < blocksX; bx++) {
+					_fetchBlock(chain.pixels.data() + src.offset, src.width, src.height, bx * 4, uint32_t(by) * 4, block);
+
+					auto out = image.data.data() + dst.offset + (by * blocksX + bx) * blockSize(format);
+					switch (format) {
+					case BlockFormat::BC1:
+						encodeBC1(block, out);
+						break;
+					case BlockFormat::BC3:
+						encodeBC3(block, out);
+						break;
+					case BlockFormat::BC7:
+						encodeBC7(block, out);
+						break;
+					}
+				}
+			});
+		}
+		return image;
+	}
+
+	static void encodeBC1(const uint8_t* block, uint8_t* out) {
+		float e0[4], e1[4];
+		_principalEndpoints(block, 3, e0, e1);
+
+		auto c0 = _packColor565(e0);
+		auto c1 = _packColor565(e1);
+
+		// four color mode needs c0 > c1, equal endpoints leave every index at 0
+		if (c0 < c1) {
+			std::swap(c0, c1);
+		}
+
+		uint8_t palette[4][3];
+		_unpackColor565(c0, palette[0]);
+		_unpackColor565(c1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = uint8_t((2 * palette[0][c] + palette[1][c] + 1) / 3);
+			palette[3][c] = uint8_t((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+		}
+
+		uint32_t indices = 0;
+		if (c0 != c1) {
+			for (int i = 0; i < 16; i++) {
+				indices |= uint32_t(_nearest(block + i * 4, &palette[0][0], 4, 3)) << (i * 2);
+			}
+		}
+
+		out[0] = uint8_t(c0);
+		out[1] = uint8_t(c0 >> 8);
+		out[2] = uint8_t(c1);
+		out[3] = uint8_t(c1 >> 8);
+		std::memcpy(out + 4, &indices, 4);
+	}
+
+	static void encodeBC3(const uint8_t* block, uint8_t* out) {
+		uint8_t a0 = 0, a1 = 0xFF;
+		for (int i = 0; i < 16; i++) {
+			a0 = std::max(a0, block[i * 4 + 3]);
+			a1 = std::min(a1, block[i * 4 + 3]);
+		}
+
+		// eight alpha mode (a0 > a1): codes 0 and 1 are the endpoints, 2..7 interpolate between them
+		uint8_t palette[8] {a0, a1};
+		for (int i = 1; i < 7; i++) {
+			palette[i + 1] = uint8_t(((7 - i) * a0 + i * a1 + 3) / 7);
+		}
+
+		uint64_t indices = 0;
+		if (a0 != a1) {
+			for (int i = 0; i < 16; i++) {
+				const int alpha = block[i * 4 + 3];
+
+				int best = 0;
+				int bestError = 256;
+				for (int code = 0; code < 8; code++) {
+					auto error = std::abs(alpha - palette[code]);
+					if (error < bestError) {
+						best = code;
+						bestError = error;
+					}
+				}
+				indices |= uint64_t(best) << (i * 3);
+			}
+		}
+
+		out[0] = a0;
+		out[1] = a1;
+		for (int i = 0; i < 6; i++) {
+			out[2 + i] = uint8_t(indices >> (i * 8));
+		}
+		encodeBC1(block, out + 8);
+	}
+
+	// mode 6: one subset, 7 bit rgba endpoints with a p-bit each and 4 bit indices
+	static void encodeBC7(const uint8_t* block, uint8_t* out) {
+		static constexpr int Weights[16] {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+		float e0[4], e1[4];
+		_principalEndpoints(block, 4, e0, e1);
+
+		uint8_t q0[4], q1[4];
+		int p0 = _quantizeEndpoint(e0, q0);
+		int p1 = _quantizeEndpoint(e1, q1);
+
+		uint8_t palette[16][4];
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				const int v0 = (q0[c] << 1) | p0;
+				const int v1 = (q1[c] << 1) | p1;
+				palette[i][c] = uint8_t(((64 - Weights[i]) * v0 + Weights[i] * v1 + 32) >> 6);
+			}
+		}
+
+		uint8_t indices[16];
+		for (int i = 0; i < 16; i++) {
+			indices[i] = uint8_t(_nearest(block + i * 4, &palette[0][0], 16, 4));
+		}
+
+		// the anchor index is stored without its top bit, so it has to be below 8
+		if (indices[0] >= 8) {
+			std::swap(q0, q1);
+			std::swap(p0, p1);
+			for (auto& index : indices) {
+				index = uint8_t(15 - index);
+			}
+		}
+
+		std::memset(out, 0, 16);
+
+		BitWriter writer{out};
+		writer.write(1u << 6, 7);
+		for (int c = 0; c < 4; c++) {
+			writer.write(q0[c], 7);
+			writer.write(q1[c], 7);
+		}
+		writer.write(uint32_t(p0), 1);
+		writer.write(uint32_t(p1), 1);
+		writer.write(indices[0], 3);
+		for (int i = 1; i < 16; i++) {
+			writer.write(indices[i], 4);
+		}
+	}
+
+private:
+	struct BitWriter {
+		uint8_t* out;
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++, position++) {
+				out[position / 8] |= uint8_t(((value >> i) & 1u) << (position % 8));
+			}
+		}
+	};
+
+	// edge blocks of small or odd sized levels repeat their last row and column
+	static void _fetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t x0, uint32_t y0, uint8_t* block) {
+		for (uint32_t y = 0; y < 4; y++) {
+			const uint32_t sy = std::min(y0 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++) {
+				const uint32_t sx = std::min(x0 + x, width - 1);
+				std::memcpy(block + (y * 4 + x) * 4, rgba + (size_t(sy) * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	// endpoints are the extreme texels projected onto the principal axis of the block
+	static void _principalEndpoints(const uint8_t* block, int channels, float* e0, float* e1) {
+		float mean[4] {};
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < channels; c++) {
+				mean[c] += block[i * 4 + c];
+			}
+		}
+		for (int c = 0; c < channels; c++) {
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] {};
+		for (int i = 0; i < 16; i++) {
+			float d[4];
+			for (int c = 0; c < channels; c++) {
+				d[c] = block[i * 4 + c] - mean[c];
+			}
+			for (int a = 0; a < channels; a++) {
+				for (int b = 0; b < channels; b++) {
+					covariance[a][b] += d[a] * d[b];
+				}
+			}
+		}
+
+		float axis[4] {1.0f, 1.0f, 1.0f, 1.0f};
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[4] {};
+			float length = 0.0f;
+			for (int a = 0; a < channels; a++) {
+				for (int b = 0; b < channels; b++) {
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length = std::max(length, std::abs(next[a]));
+			}
+			if (length == 0.0f) {
+				break;
+			}
+			for (int c = 0; c < channels; c++) {
+				axis[c] = next[c] / length;
+			}
+		}
+
+		float minT = INFINITY, maxT = -INFINITY;
+		for (int i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (int c = 0; c < channels; c++) {
+				t += (block[i * 4 + c] - mean[c]) * axis[c];
+			}
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		float lengthSq = 0.0f;
+		for (int c = 0; c < channels; c++) {
+			lengthSq += axis[c] * axis[c];
+		}
+		if (lengthSq == 0.0f) {
+			lengthSq = 1.0f;
+		}
+
+		for (int c = 0; c < channels; c++) {
+			e0[c] = std::clamp(mean[c] + axis[c] * minT / lengthSq, 0.0f, 255.0f);
+			e1[c] = std::clamp(mean[c] + axis[c] * maxT / lengthSq, 0.0f, 255.0f);
+		}
+	}
+
+	static int _nearest(const uint8_t* texel, const uint8_t* palette, int count, int channels) {
+		int best = 0;
+		int bestError = INT32_MAX;
+		for (int i = 0; i < count; i++) {
+			int error = 0;
+			for (int c = 0; c < channels; c++) {
+				const int d = int(texel[c]) - palette[i * channels + c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				best = i;
+				bestError = error;
+			}
+		}
+		return best;
+	}
+
+	static uint16_t _packColor565(const float* color) {
+		auto r = uint16_t(std::lround(color[0] * 31.0f / 255.0f));
+		auto g = uint16_t(std::lround(color[1] * 63.0f / 255.0f));
+		auto b = uint16_t(std::lround(color[2] * 31.0f / 255.0f));
+		return uint16_t((r << 11) | (g << 5) | b);
+	}
+
+	static void _unpackColor565(uint16_t color, uint8_t* out) {
+		const int r = (color >> 11) & 31;
+		const int g = (color >> 5) & 63;
+		const int b = color & 31;
+		out[0] = uint8_t((r << 3) | (r >> 2));
+		out[1] = uint8_t((g << 2) | (g >> 4));
+		out[2] = uint8_t((b << 3) | (b >> 2));
+	}
+
+	// picks the shared p-bit that reconstructs the endpoint with the least error, returns it
+	static int _quantizeEndpoint(const float* color, uint8_t* out) {
+		int bestBit = 0;
+		float bestError = INFINITY;
+		for (int bit = 0; bit < 2; bit++) {
+			float error = 0.0f;
+			uint8_t quantized[4];
+			for (int c = 0; c < 4; c++) {
+				quantized[c] = uint8_t(std::clamp(std::lround((color[c] - float(bit)) / 2.0f), 0l, 127l));
+				const float d = float((quantized[c] << 1) | bit) - color[c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestBit = bit;
+				bestError = error;
+				std::memcpy(out, quantized, 4);
+			}
+		}
+		return bestBit;
+	}
+};
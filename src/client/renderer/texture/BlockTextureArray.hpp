@@ -0,0 +1,150 @@
+#pragma once
+
+#include "resources/ResourceManager.hpp"
+
+#include "TextureManager.hpp"
+#include "TextureAtlas.hpp"
+#include "MipChain.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// alternative to TextureAtlas that puts every block texture into its own layer of a 2d array texture
+// with a full mip chain, items address a layer and use tile-local uvs
+struct BlockTextureArray : Texture {
+	std::string texture_name;
+	uint32_t tileSize = 0;
+	uint32_t levelCount = 1;
+
+	std::vector<std::string> layers;
+	std::map<std::string, TextureAtlasTextureItem> items;
+
+	void loadMetaFile(Handle<ResourceManager> resourceManager) {
+		auto bytes = resourceManager->viewFile("textures/terrain_texture.json").value();
+		auto object = Json::parse(bytes.begin(), bytes.end());
+
+		texture_name = object.at("texture_name").get<std::string>();
+
+		std::vector<ParsedAtlasNode> nodes;
+		TextureAtlas::_loadAtlasNodes(object.at("texture_data"), nodes);
+
+		std::set<std::string> requireTextures;
+		for (auto& node : nodes) {
+			for (auto& element : node.elements) {
+				requireTextures.emplace(element.path);
+			}
+		}
+
+		std::map<std::string, NativeImage> images;
+		std::map<uint32_t, int> sizes;
+		for (auto& path : requireTextures) {
+			if (auto image = resourceManager->loadTextureData(path)) {
+				sizes[uint32_t(image->width)] += 1;
+				images.emplace(path, *image);
+			}
+		}
+
+		if (images.empty()) {
+			return;
+		}
+
+		// the most common width wins, flipbooks keep their first frame and other sizes are resampled
+		tileSize = std::max_element(sizes.begin(), sizes.end(), [](auto& a, auto& b) {
+			return a.second < b.second;
+		})->first;
+		levelCount = MipChain::fullLevelCount(tileSize, tileSize);
+
+		std::map<std::string, uint32_t> layerIndices;
+		pixels.resize(size_t(tileSize) * tileSize * 4 * images.size());
+		for (auto& [path, image] : images) {
+			auto layer = uint32_t(layers.size());
+			_copyLayer(image, pixels.data() + size_t(tileSize) * tileSize * 4 * layer);
+			stbi_image_free(image.pixels);
+
+			layerIndices.emplace(path, layer);
+			layers.emplace_back(path);
+		}
+
+		for (auto& node : nodes) {
+			auto& item = items[node.name];
+			item.name = node.name;
+			item.textures.reserve(node.elements.size());
+
+			for (auto& element : node.elements) {
+				auto it = layerIndices.find(element.path);
+				item.textures.emplace_back(TextureUVCoordinateSet{
+					.minU = 0,
+					.minV = 0,
+					.maxU = 1,
+					.maxV = 1,
+					.layer = it != layerIndices.end() ? it->second : 0
+				});
+			}
+		}
+	}
+
+	TextureAtlasTextureItem& getTextureItem(const std::string& name) {
+		return items.at(name);
+	}
+
+	void loadTexture(TextureManager* textureManager) override {
+		if (layers.empty()) {
+			return;
+		}
+
+		const auto layerSize = size_t(tileSize) * tileSize * 4;
+		const auto layerCount = uint32_t(layers.size());
+
+		std::vector<MipChain> chains(layerCount);
+		ThreadPool::Instance()->parallel_for(layerCount, [&](size_t layer) {
+			chains[layer] = MipChain::build(pixels.data() + layerSize * layer, tileSize, tileSize, levelCount);
+		});
+
+		// staging data is ordered level by level so every level becomes a single copy covering all layers
+		std::vector<uint8_t> data;
+		std::vector<vk::BufferImageCopy> regions;
+		data.reserve(chains.front().pixels.size() * layerCount);
+		for (uint32_t level = 0; level < levelCount; level++) {
+			auto& mip = chains.front().levels[level];
+
+			regions.emplace_back(vk::BufferImageCopy{
+				.bufferOffset = data.size(),
+				.imageSubresource {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.mipLevel = level,
+					.baseArrayLayer = 0,
+					.layerCount = layerCount
+				},
+				.imageExtent = {
+					.width = mip.width,
+					.height = mip.height,
+					.depth = 1
+				}
+			});
+
+			for (auto& chain : chains) {
+				auto begin = chain.pixels.begin() + ptrdiff_t(mip.offset);
+				data.insert(data.end(), begin, begin + ptrdiff_t(size_t(mip.width) * mip.height * 4));
+			}
+		}
+
+		renderTexture = textureManager->createTextureArray(vk::Format::eR8G8B8A8Unorm, tileSize, tileSize, layerCount, levelCount, data, regions);
+
+		pixels.clear();
+		pixels.shrink_to_fit();
+	}
+
+private:
+	void _copyLayer(const NativeImage& image, uint8_t* dst) const {
+		const auto frameSize = uint32_t(std::min(image.width, image.height));
+		for (uint32_t y = 0; y < tileSize; y++) {
+			for (uint32_t x = 0; x < tileSize; x++) {
+				image.readRgba(int(x * frameSize / tileSize), int(y * frameSize / tileSize), dst + (size_t(y) * tileSize + x) * 4);
+			}
+		}
+	}
+
+	std::vector<uint8_t> pixels;
+};
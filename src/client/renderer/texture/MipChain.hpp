@@ -0,0 +1,159 @@
+#pragma once
+
+#include "util/ThreadPool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VCRAFT_MIPCHAIN_SSE2 1
+#endif
+
+struct MipLevel {
+	uint32_t width;
+	uint32_t height;
+	size_t offset;
+};
+
+// rgba8 mip chain stored level after level in one buffer
+struct MipChain {
+	inline static constexpr uint32_t RowsPerBand = 64;
+
+	std::vector<uint8_t> pixels;
+	std::vector<MipLevel> levels;
+
+	static uint32_t fullLevelCount(uint32_t width, uint32_t height) {
+		return std::bit_width(std::max(width, height));
+	}
+
+	static MipChain build(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t levelCount) {
+		levelCount = std::clamp(levelCount, 1u, fullLevelCount(width, height));
+
+		MipChain chain;
+		chain.levels.reserve(levelCount);
+
+		size_t size = 0;
+		for (uint32_t level = 0, w = width, h = height; level < levelCount; level++) {
+			chain.levels.emplace_back(MipLevel{w, h, size});
+			size += size_t(w) * h * 4;
+			w = std::max(w / 2, 1u);
+			h = std::max(h / 2, 1u);
+		}
+
+		chain.pixels.resize(size);
+		std::memcpy(chain.pixels.data(), rgba, size_t(width) * height * 4);
+
+		// large levels are split into row bands across the worker threads, small ones stay on the caller
+		for (uint32_t level = 1; level < levelCount; level++) {
+			auto& src = chain.levels[level - 1];
+			auto& dst = chain.levels[level];
+
+			auto bands = (dst.height + RowsPerBand - 1) / RowsPerBand;
+			ThreadPool::Instance()->parallel_for(bands, [&](size_t band) {
+				auto y0 = uint32_t(band) * RowsPerBand;
+				auto y1 = std::min(y0 + RowsPerBand, dst.height);
+				downsample(chain.pixels.data() + src.offset, src.width, src.height, chain.pixels.data() + dst.offset, dst.width, y0, y1);
+			});
+		}
+		return chain;
+	}
+
+	// 2x2 box filter over destination rows [y0, y1) that weights color by alpha,
+	// so cutout texels do not bleed their (often black) color into the result
+	static void downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t y0, uint32_t y1) {
+		for (uint32_t y = y0; y < y1; y++) {
+			const uint32_t sy0 = std::min(y * 2, srcHeight - 1);
+			const uint32_t sy1 = std::min(y * 2 + 1, srcHeight - 1);
+			const uint8_t* row0 = src + size_t(sy0) * srcWidth * 4;
+			const uint8_t* row1 = src + size_t(sy1) * srcWidth * 4;
+			uint8_t* out = dst + size_t(y) * dstWidth * 4;
+
+			uint32_t x = 0;
+#if VCRAFT_MIPCHAIN_SSE2
+			// two destination texels per step while their four source columns are inside the row,
+			// an odd last column is clamped by the scalar loop below
+			for (; x + 2 <= dstWidth && x * 2 + 4 <= srcWidth; x += 2) {
+				const __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + size_t(x) * 8));
+				const __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + size_t(x) * 8));
+
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i topLeft = _mm_unpacklo_epi8(top, zero);
+				const __m128i topRight = _mm_unpackhi_epi8(top, zero);
+				const __m128i bottomLeft = _mm_unpacklo_epi8(bottom, zero);
+				const __m128i bottomRight = _mm_unpackhi_epi8(bottom, zero);
+
+				const __m128i first = _filter(
+					_mm_unpacklo_epi16(topLeft, zero), _mm_unpackhi_epi16(topLeft, zero),
+					_mm_unpacklo_epi16(bottomLeft, zero), _mm_unpackhi_epi16(bottomLeft, zero)
+				);
+				const __m128i second = _filter(
+					_mm_unpacklo_epi16(topRight, zero), _mm_unpackhi_epi16(topRight, zero),
+					_mm_unpacklo_epi16(bottomRight, zero), _mm_unpackhi_epi16(bottomRight, zero)
+				);
+
+				const __m128i packed = _mm_packs_epi32(first, second);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(out + size_t(x) * 4), _mm_packus_epi16(packed, packed));
+			}
+#endif
+
+			for (; x < dstWidth; x++) {
+				const uint32_t x0 = std::min(x * 2, srcWidth - 1);
+				const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+				const uint8_t* texels[4] {
+					row0 + size_t(x0) * 4,
+					row0 + size_t(x1) * 4,
+					row1 + size_t(x0) * 4,
+					row1 + size_t(x1) * 4
+				};
+
+				uint32_t alpha = 0;
+				uint32_t weighted[3] {};
+				uint32_t plain[3] {};
+				for (auto texel : texels) {
+					alpha += texel[3];
+					for (int c = 0; c < 3; c++) {
+						weighted[c] += texel[c] * texel[3];
+						plain[c] += texel[c];
+					}
+				}
+
+				auto pixel = out + size_t(x) * 4;
+				for (int c = 0; c < 3; c++) {
+					pixel[c] = uint8_t(alpha != 0 ? (weighted[c] + alpha / 2) / alpha : (plain[c] + 2) / 4);
+				}
+				pixel[3] = uint8_t((alpha + 2) / 4);
+			}
+		}
+	}
+
+private:
+#if VCRAFT_MIPCHAIN_SSE2
+	// one destination texel from four rgba texels widened to 32 bits, rounds exactly like the scalar loop.
+	// the sums stay below 2^24, so they are exact as floats and the quotient never rounds up to the next integer
+	static __m128i _filter(__m128i a, __m128i b, __m128i c, __m128i d) {
+		const __m128i plain = _mm_add_epi32(_mm_add_epi32(a, b), _mm_add_epi32(c, d));
+		const __m128i alpha = _mm_shuffle_epi32(plain, _MM_SHUFFLE(3, 3, 3, 3));
+
+		auto weight = [](__m128i texel) {
+			const __m128 value = _mm_cvtepi32_ps(texel);
+			return _mm_mul_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3)));
+		};
+		const __m128 weighted = _mm_add_ps(_mm_add_ps(weight(a), weight(b)), _mm_add_ps(weight(c), weight(d)));
+
+		const __m128 numerator = _mm_add_ps(weighted, _mm_cvtepi32_ps(_mm_srli_epi32(alpha, 1)));
+		const __m128 denominator = _mm_max_ps(_mm_cvtepi32_ps(alpha), _mm_set1_ps(1.0f));
+		const __m128i premultiplied = _mm_cvttps_epi32(_mm_div_ps(numerator, denominator));
+		const __m128i average = _mm_srli_epi32(_mm_add_epi32(plain, _mm_set1_epi32(2)), 2);
+
+		// color comes from the weighted sum unless every texel is transparent, alpha is always the plain average
+		const __m128i colorLanes = _mm_set_epi32(0, -1, -1, -1);
+		const __m128i useWeighted = _mm_andnot_si128(_mm_cmpeq_epi32(alpha, _mm_setzero_si128()), colorLanes);
+		return _mm_or_si128(_mm_and_si128(useWeighted, premultiplied), _mm_andnot_si128(useWeighted, average));
+	}
+#endif
+};
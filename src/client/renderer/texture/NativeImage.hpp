@@ -2,6 +2,8 @@
 
 #include "client/util/stb_image.hpp"
 
+#include <cstdint>
+#include <cstring>
 #include <span>
 
 struct NativeImage {
@@ -10,17 +12,43 @@ struct NativeImage {
 	int height = 0;
 	int channels = 0;
 
-	static NativeImage read(std::span<char> bytes) {
+	// desiredChannels of 0 keeps the file's own channel count, anything else converts to that many
+	static NativeImage read(std::span<const char> bytes, int desiredChannels = 0) {
 		auto data = reinterpret_cast<const unsigned char *>(bytes.data());
 
 		int width, height, channels;
-		auto pixels = stbi_load_from_memory(data, bytes.size(), &width, &height, &channels, 0);
+		auto pixels = stbi_load_from_memory(data, bytes.size(), &width, &height, &channels, desiredChannels);
 
 		return NativeImage{
 			.pixels = pixels,
 			.width = width,
 			.height = height,
-			.channels = channels
+			.channels = desiredChannels != 0 ? desiredChannels : channels
 		};
 	}
+
+	// expands the texel at (x, y) to rgba8 whatever the source channel count
+	void readRgba(int x, int y, uint8_t* out) const {
+		auto texel = static_cast<const uint8_t*>(pixels) + (size_t(y) * width + x) * channels;
+
+		switch (channels) {
+		case 1:
+			out[0] = out[1] = out[2] = texel[0];
+			out[3] = 0xFF;
+			break;
+		case 2:
+			out[0] = out[1] = out[2] = texel[0];
+			out[3] = texel[1];
+			break;
+		case 3:
+			out[0] = texel[0];
+			out[1] = texel[1];
+			out[2] = texel[2];
+			out[3] = 0xFF;
+			break;
+		default:
+			std::memcpy(out, texel, 4);
+			break;
+		}
+	}
 };
\ No newline at end of file
@@ -5,7 +5,13 @@
 #include "client/renderer/TextureUVCoordinateSet.hpp"
 
 #include "NativeImage.hpp"
+#include "MipChain.hpp"
+#include "AtlasCache.hpp"
+#include "TextureCache.hpp"
 
+#include <bit>
+#include <cstring>
+#include <optional>
 #include <string>
 #include <vector>
 #include <map>
@@ -119,8 +125,13 @@ struct TextureAtlasPack {
 		Rect2D rect;
 	};
 
+	explicit TextureAtlasPack(int padding = 0) : padding(padding) {}
+
+	// every sprite reserves a border of padding texels on each side
 	void addSprite(const TextureAtlasSprite::Info& info) {
-		holders.emplace_back(std::make_unique<Holder>(info));
+		auto& holder = holders.emplace_back(std::make_unique<Holder>(info));
+		holder->width += padding * 2;
+		holder->height += padding * 2;
 	}
 
 	bool expandAndAllocateSlot(Holder* holder) {
@@ -176,8 +187,8 @@ struct TextureAtlasPack {
 		}
 
 		std::vector<TextureAtlasSprite> sprites;
-		getAllSlots([&sprites](Slot *slot) {
-			sprites.emplace_back(std::move(slot->holder->info), slot->rect.x, slot->rect.y);
+		getAllSlots([this, &sprites](Slot *slot) {
+			sprites.emplace_back(std::move(slot->holder->info), slot->rect.x + padding, slot->rect.y + padding);
 		});
 
 		return SheetData(std::move(sprites), currentWidth, currentHeight);
@@ -205,6 +216,7 @@ private:
 	std::vector<std::unique_ptr<Holder>> holders;
 	std::vector<std::unique_ptr<Slot>> slots;
 
+	int padding;
 	int currentWidth;
 	int currentHeight;
 };
@@ -246,7 +258,12 @@ struct TextureAtlas : Texture {
 
 	std::map<std::string, TextureAtlasTextureItem> items;
 
-	void _readElement(Json& data, ParsedAtlasNodeElement& element) {
+	// the finished sheet is kept in directory and reused for as long as its sources don't change
+	void enableCache(const std::filesystem::path& directory) {
+		cache.emplace(directory);
+	}
+
+	static void _readElement(Json& data, ParsedAtlasNodeElement& element) {
 		if (data.is_string()) {
 			element.path = data.get<std::string>();
 		} else {
@@ -260,7 +277,7 @@ struct TextureAtlas : Texture {
 		}
 	}
 
-	void _readNode(Json& data, ParsedAtlasNode& node) {
+	static void _readNode(Json& data, ParsedAtlasNode& node) {
 		node.quad = data.value<int>("quad", 0);
 
 		auto textures = data.at("textures");
@@ -273,14 +290,15 @@ struct TextureAtlas : Texture {
 		}
 	}
 
-	void _loadAtlasNodes(Json& texture_data, std::vector<ParsedAtlasNode>& nodes) {
+	static void _loadAtlasNodes(Json& texture_data, std::vector<ParsedAtlasNode>& nodes) {
 		for (auto& item : texture_data.items()) {
 			_readNode(item.value(), nodes.emplace_back(item.key()));
 		}
 	}
 
 	void loadMetaFile(Handle<ResourceManager> resourceManager) {
-		auto object = Json::parse(resourceManager->loadFile("textures/terrain_texture.json").value());
+		auto bytes = resourceManager->viewFile("textures/terrain_texture.json").value();
+		auto object = Json::parse(bytes.begin(), bytes.end());
 
 		auto resource_pack_name = object.at("resource_pack_name").get<std::string>();
 		texture_name = object.at("texture_name").get<std::string>();
@@ -299,9 +317,24 @@ struct TextureAtlas : Texture {
 			}
 		}
 
-		TextureAtlasPack textureAtlasPack;
-		for (auto &path : requireTextures) {
-			textureAtlasPack.addSprite({path, resourceManager->loadTextureData(path).value()});
+		std::vector<std::string> paths(requireTextures.begin(), requireTextures.end());
+
+		if (cache) {
+			sourceKey = _sourceKey(bytes, paths, resourceManager);
+			if (sourceKey && _loadCached()) {
+				return;
+			}
+		}
+
+		// decoding dominates the atlas build, every image is decoded to rgba8 on its own worker
+		std::vector<std::optional<NativeImage>> images(paths.size());
+		ThreadPool::Instance()->parallel_for(paths.size(), [&](size_t i) {
+			images[i] = resourceManager->loadTextureData(paths[i], 4);
+		});
+
+		TextureAtlasPack textureAtlasPack(padding);
+		for (size_t i = 0; i < paths.size(); i++) {
+			textureAtlasPack.addSprite({paths[i], images[i].value()});
 		}
 		sheet = textureAtlasPack.build();
 
@@ -339,29 +372,136 @@ struct TextureAtlas : Texture {
 	}
 
 	void loadTexture(TextureManager* textureManager) override {
+		// a sheet loaded from the cache has a source key, so its compressed blocks can be found without reading it
+		std::optional<uint64_t> compressedKey;
+		if (textureManager->compressionEnabled() && sourceKey) {
+			compressedKey = textureManager->cacheKey(std::span(reinterpret_cast<const uint8_t*>(&*sourceKey), sizeof(*sourceKey)), _mipLevelCount());
+			if (cachedPixels) {
+				if (auto texture = textureManager->loadCompressedTexture(*compressedKey)) {
+					renderTexture = texture;
+					cachedPixels = {};
+					return;
+				}
+			}
+		}
+
 		std::vector<uint8_t> pixels{};
-		pixels.resize(sheet->width * sheet->height * 4);
+		auto sheetPixels = reinterpret_cast<const uint8_t*>(cachedPixels.data());
+		if (!cachedPixels) {
+			pixels.resize(sheet->width * sheet->height * 4);
+
+			// sprites never overlap, including their padding, so each one is written by a single worker
+			ThreadPool::Instance()->parallel_for(sheet->sprites.size(), [&](size_t i) {
+				_blitSprite(sheet->sprites[i], pixels.data());
+			});
+
+			if (cache && sourceKey) {
+				_storeCached(pixels);
+			}
+			sheetPixels = pixels.data();
+		}
+
+		auto chain = MipChain::build(sheetPixels, sheet->width, sheet->height, _mipLevelCount());
+		cachedPixels = {};
+
+		if (textureManager->compressionEnabled()) {
+			auto key = compressedKey ? *compressedKey : textureManager->cacheKey(pixels, uint32_t(chain.levels.size()));
+			renderTexture = textureManager->createCompressedTexture(key, chain);
+		} else {
+			renderTexture = textureManager->createTexture(vk::Format::eR8G8B8A8Unorm, chain);
+		}
+	}
+
+private:
+	// the meta file together with the size and modification time of every sprite's file, nothing when
+	// one of them is missing. how the sprites are decoded and packed is covered by AtlasCache::Version
+	static std::optional<uint64_t> _sourceKey(const AssetView& meta, const std::vector<std::string>& paths, Handle<ResourceManager> resourceManager) {
+		auto key = TextureCache::hash(std::span(reinterpret_cast<const uint8_t*>(meta.data()), meta.size()));
+		for (auto& path : paths) {
+			auto stamp = resourceManager->stampTextureFile(path);
+			if (!stamp) {
+				return std::nullopt;
+			}
+			key = TextureCache::hash(std::span(reinterpret_cast<const uint8_t*>(path.data()), path.size()), key);
+			key = TextureCache::hash(std::span(reinterpret_cast<const uint8_t*>(&*stamp), sizeof(*stamp)), key);
+		}
+		return key;
+	}
+
+	// sprites come back without pixels, the sheet they were stitched into is loaded in their place
+	bool _loadCached() {
+		auto entry = cache->load(texture_name, *sourceKey);
+		if (!entry) {
+			return false;
+		}
+
+		std::vector<TextureAtlasSprite> sprites;
+		sprites.reserve(entry->sprites.size());
+		for (auto& sprite : entry->sprites) {
+			auto image = NativeImage{.width = sprite.width, .height = sprite.height, .channels = 4};
+			sprites.emplace_back(TextureAtlasSprite::Info{std::move(sprite.path), image}, sprite.x, sprite.y);
+		}
+		sheet.emplace(std::move(sprites), int(entry->width), int(entry->height));
+
+		for (auto& item : entry->items) {
+			items[item.name].textures = std::move(item.textures);
+		}
+
+		cachedPixels = std::move(entry->pixels);
+		return true;
+	}
+
+	void _storeCached(std::span<const uint8_t> pixels) const {
+		AtlasCache::Entry entry{.width = uint32_t(sheet->width), .height = uint32_t(sheet->height)};
+
+		entry.sprites.reserve(sheet->sprites.size());
 		for (auto& sprite : sheet->sprites) {
-			Rect2D rect {
-				sprite.originX,
-				sprite.originY,
-				sprite.info.width(),
-				sprite.info.height()
-			};
-
-			int i2 = 0;
-			for (int y = rect.y; y < rect.y + rect.height; y++) {
-				auto i = (y * sheet->width + rect.x) * 4;
-
-				for (int x = 0; x < rect.width; x++) {
-					pixels[i++] = reinterpret_cast<unsigned char*>(sprite.info.pixels())[i2++];
-					pixels[i++] = reinterpret_cast<unsigned char*>(sprite.info.pixels())[i2++];
-					pixels[i++] = reinterpret_cast<unsigned char*>(sprite.info.pixels())[i2++];
-					pixels[i++] = reinterpret_cast<unsigned char*>(sprite.info.pixels())[i2++];
-				}
+			entry.sprites.emplace_back(AtlasCache::Sprite{sprite.info.path, sprite.originX, sprite.originY, sprite.info.width(), sprite.info.height()});
+		}
+
+		entry.items.reserve(items.size());
+		for (auto& [name, item] : items) {
+			entry.items.emplace_back(AtlasCache::Item{name, item.textures});
+		}
+
+		cache->store(texture_name, *sourceKey, entry, pixels);
+	}
+
+	// copies the sprite row by row and extrudes its edge texels into the padding around it,
+	// sprites are decoded to rgba8 so every row is a single memcpy
+	void _blitSprite(const TextureAtlasSprite& sprite, uint8_t* pixels) const {
+		auto& image = sprite.info.image;
+		const auto source = static_cast<const uint8_t*>(image.pixels);
+		const auto rowBytes = size_t(image.width) * 4;
+		const auto paddedRowBytes = rowBytes + size_t(padding) * 8;
+
+		auto row = [&](int y) {
+			return pixels + (size_t(sprite.originY + y) * sheet->width + sprite.originX) * 4;
+		};
+
+		for (int y = 0; y < image.height; y++) {
+			auto out = row(y);
+			std::memcpy(out, source + y * rowBytes, rowBytes);
+
+			for (int x = 1; x <= padding; x++) {
+				std::memcpy(out - x * 4, out, 4);
+				std::memcpy(out + rowBytes + (x - 1) * 4, out + rowBytes - 4, 4);
 			}
 		}
 
-		renderTexture = textureManager->createTexture(vk::Format::eR8G8B8A8Unorm, sheet->width, sheet->height, 4, pixels.data());
+		for (int y = 1; y <= padding; y++) {
+			std::memcpy(row(-y) - padding * 4, row(0) - padding * 4, paddedRowBytes);
+			std::memcpy(row(image.height - 1 + y) - padding * 4, row(image.height - 1) - padding * 4, paddedRowBytes);
+		}
+	}
+
+	// a texel of level n covers 2^n texels of level 0, so levels past the padding would mix neighbouring sprites
+	uint32_t _mipLevelCount() const {
+		auto paddingLevels = uint32_t(std::bit_width(uint32_t(std::max(padding, 1))));
+		return std::clamp(uint32_t(std::max(num_mip_levels, 1)), 1u, paddingLevels);
 	}
+
+	std::optional<AtlasCache> cache;
+	std::optional<uint64_t> sourceKey;
+	AssetView cachedPixels;
 };
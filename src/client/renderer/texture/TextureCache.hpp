@@ -0,0 +1,132 @@
+#pragma once
+
+#include "BlockEncoder.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <system_error>
+
+#include <fmt/format.h>
+
+// block compressed textures stored on disk, one file per texture named after the hash of its source
+struct TextureCache {
+	inline static constexpr uint32_t Magic = 0x43424356; // "VCBC"
+	inline static constexpr uint32_t Version = 1;
+
+	explicit TextureCache(std::filesystem::path directory) : directory(std::move(directory)) {
+		std::error_code ec;
+		std::filesystem::create_directories(this->directory, ec);
+	}
+
+	// fnv-1a, the seed mixes in everything besides the source that changes the encoded result
+	static uint64_t hash(std::span<const uint8_t> bytes, uint64_t seed = 0) {
+		uint64_t value = 0xcbf29ce484222325ull ^ (seed * 0x100000001b3ull);
+		for (auto byte : bytes) {
+			value ^= byte;
+			value *= 0x100000001b3ull;
+		}
+		return value;
+	}
+
+	// a missing, truncated or damaged entry is a miss, sizes are checked against the file before anything is allocated
+	std::optional<CompressedImage> load(uint64_t key) const {
+		auto path = _path(key);
+
+		std::error_code ec;
+		const auto fileSize = std::filesystem::file_size(path, ec);
+		if (ec || fileSize < sizeof(Header)) {
+			return std::nullopt;
+		}
+
+		std::ifstream ifs(path, std::ios::binary);
+		if (!ifs) {
+			return std::nullopt;
+		}
+
+		Header header{};
+		ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!ifs || header.magic != Magic || header.version != Version || !_validFormat(header.format)) {
+			return std::nullopt;
+		}
+		if (header.levelCount == 0 || header.levelCount > MaxLevels || sizeof(Header) + sizeof(MipLevel) * header.levelCount + header.dataSize != fileSize) {
+			return std::nullopt;
+		}
+
+		CompressedImage image{.format = BlockFormat(header.format)};
+		image.levels.resize(header.levelCount);
+		image.data.resize(header.dataSize);
+
+		ifs.read(reinterpret_cast<char*>(image.levels.data()), std::streamsize(sizeof(MipLevel) * image.levels.size()));
+		ifs.read(reinterpret_cast<char*>(image.data.data()), std::streamsize(image.data.size()));
+		if (!ifs) {
+			return std::nullopt;
+		}
+
+		// every level's blocks have to lie inside data, otherwise the upload would copy past the staging buffer
+		const auto blockSize = BlockEncoder::blockSize(image.format);
+		for (auto& level : image.levels) {
+			if (level.width == 0 || level.height == 0 || level.offset > image.data.size()) {
+				return std::nullopt;
+			}
+			const auto levelSize = uint64_t((level.width + 3) / 4) * ((level.height + 3) / 4) * blockSize;
+			if (levelSize > image.data.size() - level.offset) {
+				return std::nullopt;
+			}
+		}
+		return image;
+	}
+
+	// written to a temporary file first, so a crash never leaves a truncated entry behind
+	void store(uint64_t key, const CompressedImage& image) const {
+		auto path = _path(key);
+		auto temp = std::filesystem::path(path).concat(".tmp");
+
+		{
+			std::ofstream ofs(temp, std::ios::binary);
+			if (!ofs) {
+				return;
+			}
+
+			Header header{
+				.magic = Magic,
+				.version = Version,
+				.format = uint32_t(image.format),
+				.levelCount = uint32_t(image.levels.size()),
+				.dataSize = image.data.size()
+			};
+			ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			ofs.write(reinterpret_cast<const char*>(image.levels.data()), std::streamsize(sizeof(MipLevel) * image.levels.size()));
+			ofs.write(reinterpret_cast<const char*>(image.data.data()), std::streamsize(image.data.size()));
+			if (!ofs) {
+				return;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(temp, path, ec);
+	}
+
+private:
+	// a 32 bit extent has at most 32 levels
+	inline static constexpr uint32_t MaxLevels = 32;
+
+	static bool _validFormat(uint32_t format) {
+		return format == uint32_t(BlockFormat::BC1) || format == uint32_t(BlockFormat::BC3) || format == uint32_t(BlockFormat::BC7);
+	}
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format;
+		uint32_t levelCount;
+		uint64_t dataSize;
+	};
+
+	std::filesystem::path _path(uint64_t key) const {
+		return directory / fmt::format("{:016x}.bc", key);
+	}
+
+	std::filesystem::path directory;
+};
@@ -3,6 +3,8 @@
 #include "client/renderer/RenderContext.hpp"
 
 #include "Texture.hpp"
+#include "MipChain.hpp"
+#include "TextureCache.hpp"
 
 #include <set>
 #include <map>
@@ -30,14 +32,48 @@ struct TextureManager {
 		textures.insert_or_assign(std::move(name), texture.get());
 	}
 
+	// without bc support on the device textures keep being uploaded as rgba8
+	void enableCompression(const std::filesystem::path& cacheDirectory) {
+		if (core->textureCompressionBCSupported()) {
+			cache.emplace(cacheDirectory);
+		}
+	}
+
+	bool compressionEnabled() const {
+		return cache.has_value();
+	}
+
 private:
 	Texture* loadTexture(const std::string& name) {
-		if (auto data = resourceManager->loadTextureData(name)) {
-			auto renderTexture = createTexture(vk::Format::eR8G8B8A8Unorm, data->width, data->height, data->channels, data->pixels);
-			stbi_image_free(data->pixels);
-			return new Texture(renderTexture);
+		auto bytes = resourceManager->viewTextureFile(name);
+		if (!bytes) {
+			return nullptr;
 		}
-		return nullptr;
+
+		// a cache hit skips decoding the source entirely
+		uint64_t key = 0;
+		if (cache) {
+			key = cacheKey(std::span(reinterpret_cast<const uint8_t*>(bytes->data()), bytes->size()), 1);
+			if (auto image = cache->load(key)) {
+				return new Texture(createTexture(*image));
+			}
+		}
+
+		auto data = NativeImage::read(*bytes);
+		if (data.pixels == nullptr) {
+			return nullptr;
+		}
+
+		std::vector<uint8_t> rgba(size_t(data.width) * data.height * 4);
+		for (int y = 0; y < data.height; y++) {
+			for (int x = 0; x < data.width; x++) {
+				data.readRgba(x, y, rgba.data() + (size_t(y) * data.width + x) * 4);
+			}
+		}
+		stbi_image_free(data.pixels);
+
+		auto chain = MipChain::build(rgba.data(), data.width, data.height, 1);
+		return new Texture(cache ? createCompressedTexture(key, chain) : createTexture(vk::Format::eR8G8B8A8Unorm, chain));
 	}
 
 public:
@@ -47,8 +83,117 @@ public:
 		return texture;
 	}
 
+	RenderTexture* createTexture(vk::Format format, const MipChain& chain) {
+		std::vector<vk::BufferImageCopy> regions;
+		regions.reserve(chain.levels.size());
+		for (uint32_t level = 0; level < uint32_t(chain.levels.size()); level++) {
+			regions.emplace_back(vk::BufferImageCopy{
+				.bufferOffset = chain.levels[level].offset,
+				.imageSubresource {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.mipLevel = level,
+					.layerCount = 1
+				},
+				.imageExtent = {
+					.width = chain.levels[level].width,
+					.height = chain.levels[level].height,
+					.depth = 1
+				}
+			});
+		}
+
+		auto levelCount = uint32_t(chain.levels.size());
+		auto texture = renderContext->createTexture2D(format, chain.levels.front().width, chain.levels.front().height, levelCount);
+		renderContext->textureSubImage(texture, chain.pixels.data(), chain.pixels.size(), regions, levelCount, 1);
+		return texture;
+	}
+
+	RenderTexture* createTexture(const CompressedImage& image) {
+		std::vector<vk::BufferImageCopy> regions;
+		regions.reserve(image.levels.size());
+		for (uint32_t level = 0; level < uint32_t(image.levels.size()); level++) {
+			regions.emplace_back(vk::BufferImageCopy{
+				.bufferOffset = image.levels[level].offset,
+				.imageSubresource {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.mipLevel = level,
+					.layerCount = 1
+				},
+				.imageExtent = {
+					.width = image.levels[level].width,
+					.height = image.levels[level].height,
+					.depth = 1
+				}
+			});
+		}
+
+		auto levelCount = uint32_t(image.levels.size());
+		auto texture = renderContext->createTexture2D(_blockFormat(image.format), image.levels.front().width, image.levels.front().height, levelCount);
+		renderContext->textureSubImage(texture, image.data.data(), image.data.size(), regions, levelCount, 1);
+		return texture;
+	}
+
+	// encodes the chain on the worker threads once, later launches upload the cached blocks.
+	// key identifies the source data, falls back to rgba8 when compression is disabled
+	RenderTexture* createCompressedTexture(uint64_t key, const MipChain& chain) {
+		if (!cache) {
+			return createTexture(vk::Format::eR8G8B8A8Unorm, chain);
+		}
+
+		auto image = cache->load(key);
+		if (!image) {
+			auto& base = chain.levels.front();
+			auto format = BlockEncoder::hasAlpha(chain.pixels.data(), size_t(base.width) * base.height) ? alphaFormat : BlockFormat::BC1;
+
+			image = BlockEncoder::encode(chain, format);
+			cache->store(key, *image);
+		}
+		return createTexture(*image);
+	}
+
+	// only what is already in the cache, null on a miss or when compression is disabled
+	RenderTexture* loadCompressedTexture(uint64_t key) {
+		if (!cache) {
+			return nullptr;
+		}
+		if (auto image = cache->load(key)) {
+			return createTexture(*image);
+		}
+		return nullptr;
+	}
+
+	uint64_t cacheKey(std::span<const uint8_t> data, uint32_t levelCount) const {
+		return TextureCache::hash(data, _cacheSeed(levelCount));
+	}
+
+	// bc7 keeps smooth alpha much better, bc3 encodes faster
+	BlockFormat alphaFormat = BlockFormat::BC7;
+
+	RenderTexture* createTextureArray(vk::Format format, uint32_t width, uint32_t height, uint32_t layers, uint32_t mipLevels, std::span<const uint8_t> data, std::span<const vk::BufferImageCopy> regions) {
+		auto texture = renderContext->createTexture2DArray(format, width, height, layers, mipLevels);
+		renderContext->textureSubImage(texture, data.data(), data.size(), regions, mipLevels, layers);
+		return texture;
+	}
+
 private:
+	static vk::Format _blockFormat(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1:
+			return vk::Format::eBc1RgbUnormBlock;
+		case BlockFormat::BC3:
+			return vk::Format::eBc3UnormBlock;
+		case BlockFormat::BC7:
+			return vk::Format::eBc7UnormBlock;
+		}
+		return vk::Format::eUndefined;
+	}
+
+	uint64_t _cacheSeed(uint32_t levelCount) const {
+		return (uint64_t(levelCount) << 8) | uint64_t(alphaFormat);
+	}
+
 	std::map<std::string, Texture*> textures;
+	std::optional<TextureCache> cache;
 
 	RenderSystem* core = RenderSystem::Instance();
 
@@ -28,6 +28,18 @@ struct Buffer {
 		vmaUnmapMemory(RenderSystem::Instance()->allocator(), allocation);
 	}
 
+	void flush(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) {
+		vmaFlushAllocation(RenderSystem::Instance()->allocator(), allocation, offset, size);
+	}
+
+	void invalidate(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) {
+		vmaInvalidateAllocation(RenderSystem::Instance()->allocator(), allocation, offset, size);
+	}
+
+	explicit operator bool() const {
+		return buffer != nullptr;
+	}
+
 	operator vk::Buffer() {
 		return buffer;
 	}
@@ -17,6 +17,10 @@ struct CommandPool {
 		RenderSystem::Instance()->device().destroyCommandPool(_commandPool, nullptr);
 	}
 
+	void reset() {
+		RenderSystem::Instance()->device().resetCommandPool(_commandPool, {});
+	}
+
 	inline vk::CommandBuffer allocate(vk::CommandBufferLevel level) {
 		vk::CommandBufferAllocateInfo allocateInfo {
 			.commandPool = _commandPool,
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+// minimal png encoder for frame captures, the image data is stored in uncompressed deflate blocks
+struct PngWriter {
+	static bool write(const std::filesystem::path& path, uint32_t width, uint32_t height, int channels, const void* pixels) {
+		std::ofstream ofs(path, std::ios::binary);
+		if (!ofs) {
+			return false;
+		}
+
+		static constexpr uint8_t signature[] { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		ofs.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+		static constexpr uint8_t color_types[] { 0, 0, 4, 2, 6 };
+
+		std::vector<uint8_t> header;
+		_put32(header, width);
+		_put32(header, height);
+		header.push_back(8);
+		header.push_back(color_types[channels]);
+		header.push_back(0);
+		header.push_back(0);
+		header.push_back(0);
+		_writeChunk(ofs, "IHDR", header);
+
+		// every row is prefixed with filter type 0 (none)
+		const size_t stride = size_t(width) * channels;
+		std::vector<uint8_t> raw;
+		raw.reserve((stride + 1) * height);
+		for (uint32_t y = 0; y < height; y++) {
+			auto row = static_cast<const uint8_t*>(pixels) + y * stride;
+			raw.push_back(0);
+			raw.insert(raw.end(), row, row + stride);
+		}
+
+		std::vector<uint8_t> zlib;
+		zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+		zlib.push_back(0x78);
+		zlib.push_back(0x01);
+
+		size_t offset = 0;
+		do {
+			auto length = std::min(raw.size() - offset, size_t(65535));
+			auto last = offset + length == raw.size();
+
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(uint8_t(length));
+			zlib.push_back(uint8_t(length >> 8));
+			zlib.push_back(uint8_t(~length));
+			zlib.push_back(uint8_t(~length >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+
+			offset += length;
+		} while (offset < raw.size());
+
+		_put32(zlib, _adler32(raw));
+		_writeChunk(ofs, "IDAT", zlib);
+		_writeChunk(ofs, "IEND", {});
+
+		return bool(ofs);
+	}
+
+private:
+	static void _put32(std::vector<uint8_t>& out, uint32_t value) {
+		out.push_back(uint8_t(value >> 24));
+		out.push_back(uint8_t(value >> 16));
+		out.push_back(uint8_t(value >> 8));
+		out.push_back(uint8_t(value));
+	}
+
+	static uint32_t _adler32(std::span<const uint8_t> bytes) {
+		uint32_t a = 1;
+		uint32_t b = 0;
+		for (auto byte : bytes) {
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	static uint32_t _crc32(uint32_t crc, std::span<const uint8_t> bytes) {
+		static const auto table = [] {
+			std::array<uint32_t, 256> table{};
+			for (uint32_t n = 0; n < 256; n++) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++) {
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			return table;
+		}();
+
+		for (auto byte : bytes) {
+			crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+		}
+		return crc;
+	}
+
+	static void _writeChunk(std::ofstream& ofs, const char (&type)[5], std::span<const uint8_t> data) {
+		std::vector<uint8_t> chunk;
+		chunk.reserve(data.size() + 12);
+		_put32(chunk, uint32_t(data.size()));
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+
+		auto crc = _crc32(0xFFFFFFFFu, std::span(chunk).subspan(4)) ^ 0xFFFFFFFFu;
+		_put32(chunk, crc);
+
+		ofs.write(reinterpret_cast<const char*>(chunk.data()), std::streamsize(chunk.size()));
+	}
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "ResourcePack.hpp"
+#include "PackArchive.hpp"
+#include "Lz4.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+// a .vpack archive built by vcraft_pack, mapped as a whole. the index is read in place, uncompressed entries
+// are views straight into the mapping and compressed ones are decoded into their own buffer
+struct ArchiveResourcePack : ResourcePack {
+	ArchiveResourcePack(std::filesystem::path path) : archivePath(std::move(path)) {}
+
+	// an archive that can't be mapped or fails validation behaves like an empty pack
+	void index() override {
+		indexed = true;
+		entries = {};
+		sortedByPath.clear();
+
+		archive = MappedFile::open(archivePath);
+		archiveModified = _modifiedTime(archivePath);
+		if (!archive || archive->size < sizeof(PackArchive::Header)) {
+			return;
+		}
+
+		PackArchive::Header header;
+		std::memcpy(&header, archive->data, sizeof(header));
+		if (std::memcmp(header.magic, PackArchive::Magic, sizeof(header.magic)) != 0 || header.version != PackArchive::Version) {
+			return;
+		}
+
+		const auto entriesSize = uint64_t(header.entryCount) * sizeof(PackArchive::Entry);
+		if (header.entriesOffset % alignof(PackArchive::Entry) != 0 || header.entriesOffset + entriesSize > archive->size || header.pathsOffset + header.pathBytes > archive->size) {
+			return;
+		}
+
+		auto all = std::span(reinterpret_cast<const PackArchive::Entry*>(archive->data + header.entriesOffset), header.entryCount);
+		for (auto& entry : all) {
+			if (entry.offset + entry.storedSize > archive->size || uint64_t(entry.pathOffset) + entry.pathLength > header.pathBytes) {
+				return;
+			}
+		}
+
+		entries = all;
+		paths = archive->data + header.pathsOffset;
+
+		sortedByPath.resize(entries.size());
+		for (uint32_t i = 0; i < entries.size(); i++) {
+			sortedByPath[i] = i;
+		}
+		std::sort(sortedByPath.begin(), sortedByPath.end(), [&](uint32_t a, uint32_t b) {
+			return _path(entries[a]) < _path(entries[b]);
+		});
+	}
+
+	bool contains(const std::filesystem::path& path) override {
+		return _find(path) != nullptr;
+	}
+
+	auto viewFile(const std::filesystem::path& path) -> std::optional<AssetView> override {
+		if (auto entry = _find(path)) {
+			return _view(*entry);
+		}
+		return std::nullopt;
+	}
+
+	auto stamp(const std::filesystem::path& path) -> std::optional<FileStamp> override {
+		if (auto entry = _find(path)) {
+			return FileStamp{entry->size, archiveModified};
+		}
+		return std::nullopt;
+	}
+
+	auto getResources(const std::filesystem::path& path) -> std::vector<AssetView> override {
+		if (!indexed) {
+			index();
+		}
+
+		std::vector<AssetView> resources;
+
+		auto prefix = _directoryPrefix(path);
+		auto it = std::lower_bound(sortedByPath.begin(), sortedByPath.end(), std::string_view(prefix), [&](uint32_t index, std::string_view value) {
+			return _path(entries[index]) < value;
+		});
+		for (; it != sortedByPath.end() && _path(entries[*it]).starts_with(prefix); ++it) {
+			if (auto view = _view(entries[*it])) {
+				resources.emplace_back(std::move(*view));
+			}
+		}
+
+		return std::move(resources);
+	}
+
+private:
+	std::string_view _path(const PackArchive::Entry& entry) const {
+		return {paths + entry.pathOffset, entry.pathLength};
+	}
+
+	const PackArchive::Entry* _find(const std::filesystem::path& path) {
+		if (!indexed) {
+			index();
+		}
+
+		const auto key = _key(path);
+		const auto hash = PackArchive::hashPath(key);
+
+		auto it = std::lower_bound(entries.begin(), entries.end(), hash, [](const PackArchive::Entry& entry, uint64_t value) {
+			return entry.pathHash < value;
+		});
+		for (; it != entries.end() && it->pathHash == hash; ++it) {
+			if (_path(*it) == key) {
+				return &*it;
+			}
+		}
+		return nullptr;
+	}
+
+	std::optional<AssetView> _view(const PackArchive::Entry& entry) const {
+		auto stored = std::span(archive->data + entry.offset, entry.storedSize);
+
+		if (entry.compression == PackArchive::Compression::None) {
+			return AssetView(stored, archive);
+		}
+
+		std::string bytes(entry.size, '\0');
+		auto source = std::span(reinterpret_cast<const uint8_t*>(stored.data()), stored.size());
+		auto destination = std::span(reinterpret_cast<uint8_t*>(bytes.data()), bytes.size());
+		if (!Lz4::decompress(source, destination)) {
+			return std::nullopt;
+		}
+		return AssetView::own(std::move(bytes));
+	}
+
+	std::filesystem::path archivePath;
+
+	bool indexed = false;
+	std::shared_ptr<MappedFile> archive;
+	int64_t archiveModified = 0;
+	std::span<const PackArchive::Entry> entries;
+	const char* paths = nullptr;
+	std::vector<uint32_t> sortedByPath;
+};
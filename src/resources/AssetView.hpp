@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// a read-only file mapping, unmapped when the last view into it goes away
+struct MappedFile {
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+#ifdef _WIN32
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+		}
+#else
+		if (data != nullptr) {
+			munmap(const_cast<char*>(data), size);
+		}
+#endif
+	}
+
+	// null when the file can't be opened, empty files map to an empty range
+	static std::shared_ptr<MappedFile> open(const std::filesystem::path& path) {
+		auto file = std::shared_ptr<MappedFile>(new MappedFile());
+
+#ifdef _WIN32
+		auto handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE) {
+			return nullptr;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(handle, &fileSize)) {
+			CloseHandle(handle);
+			return nullptr;
+		}
+		file->size = size_t(fileSize.QuadPart);
+
+		if (file->size != 0) {
+			auto mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr) {
+				file->data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(handle);
+#else
+		auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return nullptr;
+		}
+
+		struct stat info{};
+		if (fstat(fd, &info) != 0) {
+			::close(fd);
+			return nullptr;
+		}
+		file->size = size_t(info.st_size);
+
+		if (file->size != 0) {
+			auto address = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address != MAP_FAILED) {
+				file->data = static_cast<const char*>(address);
+			}
+		}
+		// the mapping stays valid after the descriptor is closed
+		::close(fd);
+#endif
+
+		if (file->size != 0 && file->data == nullptr) {
+			return nullptr;
+		}
+		return file;
+	}
+
+	const char* data = nullptr;
+	size_t size = 0;
+
+private:
+	MappedFile() = default;
+};
+
+// read-only bytes of an asset together with whatever keeps them alive, usually a file mapping.
+// copies share the owner, so a view can be handed around freely and never copies the bytes themselves
+struct AssetView {
+	AssetView() = default;
+	AssetView(std::span<const char> bytes, std::shared_ptr<const void> owner) : bytes(bytes), owner(std::move(owner)) {}
+
+	static AssetView map(const std::filesystem::path& path) {
+		auto file = MappedFile::open(path);
+		if (!file) {
+			return {};
+		}
+		auto bytes = std::span(file->data, file->size);
+		return AssetView(bytes, std::move(file));
+	}
+
+	// for bytes that only exist in memory, e.g. after decompression
+	static AssetView own(std::string bytes) {
+		auto storage = std::make_shared<const std::string>(std::move(bytes));
+		return AssetView(std::span(storage->data(), storage->size()), storage);
+	}
+
+	explicit operator bool() const {
+		return owner != nullptr;
+	}
+
+	operator std::span<const char>() const {
+		return bytes;
+	}
+
+	const char* data() const {
+		return bytes.data();
+	}
+
+	size_t size() const {
+		return bytes.size();
+	}
+
+	const char* begin() const {
+		return bytes.data();
+	}
+
+	const char* end() const {
+		return bytes.data() + bytes.size();
+	}
+
+	std::string_view str() const {
+		return {bytes.data(), bytes.size()};
+	}
+
+	// a part of this view that keeps the same owner alive
+	AssetView subview(size_t offset, size_t count) const {
+		return AssetView(bytes.subspan(offset, count), owner);
+	}
+
+private:
+	std::span<const char> bytes;
+	std::shared_ptr<const void> owner;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// the lz4 block format: greedy matching against a hash of the last position each 4 byte sequence was seen at.
+// fast to decode and good enough for json and other text assets, images are stored as they are
+namespace Lz4 {
+	inline constexpr size_t MinMatch = 4;
+	// the format ends every block with literals, the last match has to start this far before the end
+	inline constexpr size_t LastLiterals = 5;
+	inline constexpr size_t MatchSafeDistance = 12;
+	inline constexpr size_t MaxOffset = 65535;
+	inline constexpr uint32_t HashBits = 16;
+
+	inline size_t compressBound(size_t size) {
+		return size + size / 255 + 16;
+	}
+
+	namespace detail {
+		inline uint32_t read32(const uint8_t* p) {
+			uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		inline uint32_t hash(uint32_t sequence) {
+			return (sequence * 2654435761u) >> (32 - HashBits);
+		}
+
+		inline void writeLength(std::vector<uint8_t>& out, size_t length) {
+			while (length >= 255) {
+				out.push_back(255);
+				length -= 255;
+			}
+			out.push_back(uint8_t(length));
+		}
+	}
+
+	inline std::vector<uint8_t> compress(std::span<const uint8_t> source) {
+		using namespace detail;
+
+		std::vector<uint8_t> out;
+		out.reserve(compressBound(source.size()));
+
+		const auto* base = source.data();
+		const size_t size = source.size();
+
+		std::vector<uint32_t> table(size_t(1) << HashBits, UINT32_MAX);
+
+		size_t anchor = 0;
+		size_t position = 0;
+
+		auto emit = [&](size_t literalEnd, size_t matchLength, size_t offset) {
+			const size_t literals = literalEnd - anchor;
+			const size_t matchCode = matchLength != 0 ? matchLength - MinMatch : 0;
+
+			out.push_back(uint8_t((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(matchCode, 15)));
+			if (literals >= 15) {
+				writeLength(out, literals - 15);
+			}
+			out.insert(out.end(), base + anchor, base + literalEnd);
+
+			if (matchLength != 0) {
+				out.push_back(uint8_t(offset));
+				out.push_back(uint8_t(offset >> 8));
+				if (matchCode >= 15) {
+					writeLength(out, matchCode - 15);
+				}
+			}
+		};
+
+		if (size >= MatchSafeDistance + 1) {
+			const size_t matchLimit = size - LastLiterals;
+			const size_t searchLimit = size - MatchSafeDistance;
+
+			while (position < searchLimit) {
+				const auto sequence = read32(base + position);
+				const auto slot = hash(sequence);
+				const auto candidate = table[slot];
+				table[slot] = uint32_t(position);
+
+				if (candidate == UINT32_MAX || position - candidate > MaxOffset || read32(base + candidate) != sequence) {
+					position++;
+					continue;
+				}
+
+				size_t length = MinMatch;
+				while (position + length < matchLimit && base[candidate + length] == base[position + length]) {
+					length++;
+				}
+
+				emit(position, length, position - candidate);
+				position += length;
+				anchor = position;
+			}
+		}
+
+		emit(size, 0, 0);
+		return out;
+	}
+
+	// false when the block is malformed or doesn't decode to exactly destination.size() bytes
+	inline bool decompress(std::span<const uint8_t> source, std::span<uint8_t> destination) {
+		const auto* in = source.data();
+		const auto* inEnd = in + source.size();
+		auto* out = destination.data();
+		auto* outEnd = out + destination.size();
+
+		auto readLength = [&](size_t length) -> size_t {
+			if (length != 15) {
+				return length;
+			}
+			uint8_t extra;
+			do {
+				if (in == inEnd) {
+					return SIZE_MAX;
+				}
+				extra = *in++;
+				length += extra;
+			} while (extra == 255);
+			return length;
+		};
+
+		while (in < inEnd) {
+			const auto token = *in++;
+
+			const auto literals = readLength(token >> 4);
+			if (literals == SIZE_MAX || size_t(inEnd - in) < literals || size_t(outEnd - out) < literals) {
+				return false;
+			}
+			if (literals != 0) {
+				std::memcpy(out, in, literals);
+			}
+			in += literals;
+			out += literals;
+
+			// the last sequence has no match
+			if (in == inEnd) {
+				break;
+			}
+
+			if (inEnd - in < 2) {
+				return false;
+			}
+			const size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+			in += 2;
+
+			auto length = readLength(token & 0x0F);
+			if (length == SIZE_MAX) {
+				return false;
+			}
+			length += MinMatch;
+
+			if (offset == 0 || size_t(out - destination.data()) < offset || size_t(outEnd - out) < length) {
+				return false;
+			}
+
+			// matches may overlap their own output, so this copies forward byte by byte
+			const auto* match = out - offset;
+			for (size_t i = 0; i < length; i++) {
+				out[i] = match[i];
+			}
+			out += length;
+		}
+
+		return out == outEnd;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// layout of a .vpack archive, written by tools/vcraft_pack.cpp and read by ArchiveResourcePack.
+// header | entries sorted by path hash | path strings | file data, every file starting on an Alignment boundary.
+// all integers are little endian
+namespace PackArchive {
+	inline constexpr char Magic[4] {'V', 'P', 'A', 'K'};
+	inline constexpr uint32_t Version = 1;
+	inline constexpr uint64_t Alignment = 16;
+
+	enum class Compression : uint16_t {
+		None,
+		Lz4
+	};
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t pathBytes;
+		uint64_t entriesOffset;
+		uint64_t pathsOffset;
+	};
+
+	struct Entry {
+		uint64_t pathHash;
+		uint64_t offset;
+		// bytes in the archive, the same as size when the entry is not compressed
+		uint32_t storedSize;
+		uint32_t size;
+		uint32_t pathOffset;
+		uint16_t pathLength;
+		Compression compression;
+	};
+
+	static_assert(sizeof(Header) == 32);
+	static_assert(sizeof(Entry) == 32);
+
+	// fnv-1a of the normalized relative path, entries with equal hashes are ordered by path
+	inline uint64_t hashPath(std::string_view path) {
+		uint64_t value = 0xcbf29ce484222325ull;
+		for (auto c : path) {
+			value ^= uint8_t(c);
+			value *= 0x100000001b3ull;
+		}
+		return value;
+	}
+
+	inline uint64_t align(uint64_t offset) {
+		return (offset + Alignment - 1) & ~(Alignment - 1);
+	}
+}
@@ -1,19 +1,42 @@
 #pragma once
 
+#include <algorithm>
 #include <filesystem>
 #include <vector>
 #include <fstream>
 #include <span>
 
 #include "ResourcePack.hpp"
+#include "ArchiveResourcePack.hpp"
+#include "ZipResourcePack.hpp"
 
 #include "client/renderer/texture/NativeImage.hpp"
 
 struct ResourceManager {
+	// the pack is indexed here, so later lookups that miss it cost no filesystem calls
 	void addResourcePack(ResourcePackPtr&& resourcePack) {
+		resourcePack->index();
 		resourcePacks.emplace_back(std::move(resourcePack));
 	}
 
+	// .vpack, .zip and .mcpack files are read in place as archives, anything else as a directory of loose files
+	void addResourcePack(const std::filesystem::path& path) {
+		const auto extension = path.extension();
+		if (extension == ".vpack") {
+			addResourcePack(std::make_unique<ArchiveResourcePack>(path));
+		} else if (extension == ".zip" || extension == ".mcpack") {
+			addResourcePack(std::make_unique<ZipResourcePack>(path));
+		} else {
+			addResourcePack(std::make_unique<DirectoryResourcePack>(path));
+		}
+	}
+
+	bool contains(const std::filesystem::path& path) {
+		return std::any_of(resourcePacks.begin(), resourcePacks.end(), [&](auto& resourcePack) {
+			return resourcePack->contains(path);
+		});
+	}
+
 	std::optional<std::string> loadFile(const std::filesystem::path& path) {
 		for (auto& resourcePack : resourcePacks) {
 			if (auto value = resourcePack->loadFile(path)) {
@@ -23,8 +46,28 @@ struct ResourceManager {
 		return std::nullopt;
 	}
 
-	std::vector<std::string> getResources(const std::filesystem::path& path) {
-		std::vector<std::string> all_resources;
+	// zero-copy access, prefer this over loadFile for anything that is only parsed
+	std::optional<AssetView> viewFile(const std::filesystem::path& path) {
+		for (auto& resourcePack : resourcePacks) {
+			if (auto view = resourcePack->viewFile(path)) {
+				return view;
+			}
+		}
+		return std::nullopt;
+	}
+
+	// the stamp of the file viewFile would return
+	std::optional<FileStamp> stamp(const std::filesystem::path& path) {
+		for (auto& resourcePack : resourcePacks) {
+			if (auto value = resourcePack->stamp(path)) {
+				return value;
+			}
+		}
+		return std::nullopt;
+	}
+
+	std::vector<AssetView> getResources(const std::filesystem::path& path) {
+		std::vector<AssetView> all_resources;
 
 		for (auto& resourcePack : resourcePacks) {
 			auto resources = resourcePack->getResources(path);
@@ -35,15 +78,32 @@ struct ResourceManager {
 		return std::move(all_resources);
 	}
 
-	std::optional<NativeImage> loadTextureData(const std::string& name) {
+	// encoded image file, without decoding it
+	std::optional<AssetView> viewTextureFile(const std::string& name) {
 		for (auto ext : {".png", ".tga"}) {
-			if (auto bytes = loadFile(name + ext)) {
-				return NativeImage::read(*bytes);
+			if (auto view = viewFile(name + ext)) {
+				return view;
 			}
 		}
 		return std::nullopt;
 	}
 
+	std::optional<FileStamp> stampTextureFile(const std::string& name) {
+		for (auto ext : {".png", ".tga"}) {
+			if (auto value = stamp(name + ext)) {
+				return value;
+			}
+		}
+		return std::nullopt;
+	}
+
+	std::optional<NativeImage> loadTextureData(const std::string& name, int desiredChannels = 0) {
+		if (auto bytes = viewTextureFile(name)) {
+			return NativeImage::read(*bytes, desiredChannels);
+		}
+		return std::nullopt;
+	}
+
 private:
 	std::vector<ResourcePackPtr> resourcePacks;
 };
@@ -1,53 +1,160 @@
 #pragma once
 
+#include "AssetView.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// identifies a version of a file without reading it, for caches of data derived from assets
+struct FileStamp {
+	uint64_t size;
+	int64_t modified;
+};
+
+// a source of assets addressed by relative paths. packs are indexed once when they are added to a
+// ResourceManager, lookups after that are answered from the index
 struct ResourcePack {
-	ResourcePack(std::filesystem::path path) : basePath(std::move(path)) {}
+	virtual ~ResourcePack() = default;
+
+	virtual void index() = 0;
+	virtual bool contains(const std::filesystem::path& path) = 0;
+
+	// the view stays valid for as long as it or a copy of it is alive
+	virtual auto viewFile(const std::filesystem::path& path) -> std::optional<AssetView> = 0;
+
+	virtual auto stamp(const std::filesystem::path& path) -> std::optional<FileStamp> = 0;
+
+	// every file below path
+	virtual auto getResources(const std::filesystem::path& path) -> std::vector<AssetView> = 0;
+
+	// an owned copy, for callers that need to modify or keep the bytes
+	auto loadFile(const std::filesystem::path& path) -> std::optional<std::string> {
+		if (auto view = viewFile(path)) {
+			return std::string(view->str());
+		}
+		return std::nullopt;
+	}
+
+protected:
+	// keys are relative, normalized and use forward slashes on every platform
+	static std::string _key(const std::filesystem::path& path) {
+		return path.lexically_normal().generic_string();
+	}
+
+	static std::string _directoryPrefix(const std::filesystem::path& path) {
+		auto prefix = _key(path);
+		if (!prefix.empty() && prefix.back() != '/') {
+			prefix += '/';
+		}
+		return prefix;
+	}
+
+	// archives are rebuilt as a whole, so their entries share the archive's modification time
+	static int64_t _modifiedTime(const std::filesystem::path& path) {
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(path, ec);
+		return ec ? 0 : int64_t(time.time_since_epoch().count());
+	}
+};
+
+using ResourcePackPtr = std::unique_ptr<ResourcePack>;
+
+// a directory of loose files. every file is listed once by index(), lookups after that never touch the
+// filesystem unless the file is actually there to be read
+struct DirectoryResourcePack : ResourcePack {
+	DirectoryResourcePack(std::filesystem::path path) : basePath(std::move(path)) {}
 
 	std::filesystem::path getFullPath(const std::filesystem::path& path) {
 		return basePath / path;
 	}
 
-	inline bool contains(const std::string& path) {
-		const auto file_path = basePath / path;
-		return std::filesystem::exists(file_path);
-	}
+	void index() override {
+		files.clear();
+		sortedPaths.clear();
+
+		// an entry that can't be inspected is skipped, only a failure to advance ends the listing
+		std::error_code ec;
+		auto it = std::filesystem::recursive_directory_iterator(basePath, std::filesystem::directory_options::skip_permission_denied, ec);
+		for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+			std::error_code entryError;
+			if (!it->is_regular_file(entryError) || entryError) {
+				continue;
+			}
+			const auto size = it->file_size(entryError);
+			if (entryError) {
+				continue;
+			}
+			auto path = it->path().lexically_relative(basePath).generic_string();
+			files.emplace(path, size);
+			sortedPaths.emplace_back(std::move(path));
+		}
 
-	inline auto loadFile(const std::filesystem::path& path) -> std::optional<std::string> {
-		const auto filePath = getFullPath(path);
-		if (std::filesystem::exists(filePath)) {
-			std::string bytes;
-			bytes.resize(std::filesystem::file_size(filePath));
+		// sorted so that a directory's files form one contiguous range
+		std::sort(sortedPaths.begin(), sortedPaths.end());
+		indexed = true;
+	}
 
-			std::ifstream file(filePath, std::ios::binary);
-			file.read(bytes.data(), bytes.size());
-			file.close();
+	bool contains(const std::filesystem::path& path) override {
+		return _find(path) != files.end();
+	}
 
-			return std::move(bytes);
+	// maps the file instead of reading it
+	auto viewFile(const std::filesystem::path& path) -> std::optional<AssetView> override {
+		auto it = _find(path);
+		if (it == files.end()) {
+			return std::nullopt;
+		}
+		if (auto view = AssetView::map(basePath / it->first)) {
+			return view;
 		}
 		return std::nullopt;
 	}
 
-	auto getResources(const std::filesystem::path& path) -> std::vector<std::string> {
-		std::vector<std::string> resources;
-
-		for (auto& entry : std::filesystem::recursive_directory_iterator(getFullPath(path))) {
-			if (entry.is_directory()) continue;
+	// the size comes from the index, only the modification time needs a filesystem call
+	auto stamp(const std::filesystem::path& path) -> std::optional<FileStamp> override {
+		auto it = _find(path);
+		if (it == files.end()) {
+			return std::nullopt;
+		}
 
-			std::string bytes;
-			bytes.resize(std::filesystem::file_size(entry.path()));
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(basePath / it->first, ec);
+		if (ec) {
+			return std::nullopt;
+		}
+		return FileStamp{uint64_t(it->second), int64_t(time.time_since_epoch().count())};
+	}
 
-			std::ifstream file(entry.path(), std::ios::binary);
-			file.read(bytes.data(), bytes.size());
-			file.close();
+	auto getResources(const std::filesystem::path& path) -> std::vector<AssetView> override {
+		std::vector<AssetView> resources;
 
-			resources.emplace_back(bytes);
+		auto prefix = _directoryPrefix(path);
+		for (auto it = std::lower_bound(sortedPaths.begin(), sortedPaths.end(), prefix); it != sortedPaths.end() && it->starts_with(prefix); ++it) {
+			if (auto view = AssetView::map(basePath / *it)) {
+				resources.emplace_back(std::move(view));
+			}
 		}
 
 		return std::move(resources);
 	}
 
 private:
+	std::unordered_map<std::string, uintmax_t>::const_iterator _find(const std::filesystem::path& path) {
+		if (!indexed) {
+			index();
+		}
+		return files.find(_key(path));
+	}
+
 	std::filesystem::path basePath;
-};
 
-using ResourcePackPtr = std::unique_ptr<ResourcePack>;
+	bool indexed = false;
+	std::unordered_map<std::string, uintmax_t> files;
+	std::vector<std::string> sortedPaths;
+};
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "ResourcePack.hpp"
+
+#include "client/util/stb_image.hpp"
+#include "util/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// a .zip or .mcpack file, mapped as a whole. the central directory is read once by index(), stored entries
+// are views straight into the mapping and deflated ones are inflated into their own buffer.
+// zip64, encryption and methods other than store and deflate are not supported, such entries are skipped
+struct ZipResourcePack : ResourcePack {
+	ZipResourcePack(std::filesystem::path path) : archivePath(std::move(path)) {}
+
+	// an archive that can't be mapped or has no readable central directory behaves like an empty pack
+	void index() override {
+		indexed = true;
+		files.clear();
+		sortedPaths.clear();
+
+		archive = MappedFile::open(archivePath);
+		archiveModified = _modifiedTime(archivePath);
+		if (!archive) {
+			return;
+		}
+
+		auto directory = _findEndOfCentralDirectory();
+		if (directory == nullptr) {
+			return;
+		}
+
+		const auto count = _read16(directory + 10);
+		const auto directorySize = _read32(directory + 12);
+		const auto directoryOffset = _read32(directory + 16);
+		if (uint64_t(directoryOffset) + directorySize > archive->size) {
+			return;
+		}
+
+		std::vector<std::pair<std::string, Entry>> entries;
+		entries.reserve(count);
+
+		const auto* it = archive->data + directoryOffset;
+		const auto* end = it + directorySize;
+		for (uint32_t i = 0; i < count; i++) {
+			if (end - it < CentralHeaderSize || _read32(it) != CentralHeaderSignature) {
+				return;
+			}
+
+			const auto flags = _read16(it + 8);
+			const auto method = _read16(it + 10);
+			const auto storedSize = _read32(it + 20);
+			const auto size = _read32(it + 24);
+			const auto nameLength = _read16(it + 28);
+			const auto extraLength = _read16(it + 30);
+			const auto commentLength = _read16(it + 32);
+			const auto headerOffset = _read32(it + 42);
+
+			const auto recordSize = CentralHeaderSize + nameLength + extraLength + commentLength;
+			if (end - it < recordSize) {
+				return;
+			}
+
+			auto name = std::string_view(it + CentralHeaderSize, nameLength);
+			it += recordSize;
+
+			// zip64 entries keep their real sizes and offset in the extra field, these only hold a marker
+			const bool encrypted = (flags & 1) != 0;
+			const bool zip64 = storedSize == Zip64Marker || size == Zip64Marker || headerOffset == Zip64Marker;
+			if (name.empty() || name.back() == '/' || encrypted || zip64 || (method != Stored && method != Deflated)) {
+				continue;
+			}
+
+			entries.emplace_back(_key(name), Entry{headerOffset, storedSize, size, method});
+		}
+
+		// packs are often zipped together with their folder, the files are addressed relative to it
+		const auto root = _commonRoot(entries);
+
+		for (auto& [path, entry] : entries) {
+			if (path.starts_with(root)) {
+				files.emplace(path.substr(root.size()), entry);
+			}
+		}
+
+		sortedPaths.reserve(files.size());
+		for (auto& file : files) {
+			sortedPaths.emplace_back(&file);
+		}
+		std::sort(sortedPaths.begin(), sortedPaths.end(), [](auto* a, auto* b) {
+			return a->first < b->first;
+		});
+	}
+
+	bool contains(const std::filesystem::path& path) override {
+		return _find(path) != nullptr;
+	}
+
+	auto viewFile(const std::filesystem::path& path) -> std::optional<AssetView> override {
+		if (auto entry = _find(path)) {
+			return _view(*entry);
+		}
+		return std::nullopt;
+	}
+
+	auto stamp(const std::filesystem::path& path) -> std::optional<FileStamp> override {
+		if (auto entry = _find(path)) {
+			return FileStamp{entry->size, archiveModified};
+		}
+		return std::nullopt;
+	}
+
+	// a directory is usually requested to load all of it, so its entries are inflated on the worker threads
+	auto getResources(const std::filesystem::path& path) -> std::vector<AssetView> override {
+		if (!indexed) {
+			index();
+		}
+
+		auto prefix = _directoryPrefix(path);
+		auto first = std::lower_bound(sortedPaths.begin(), sortedPaths.end(), std::string_view(prefix), [](auto* file, std::string_view value) {
+			return std::string_view(file->first) < value;
+		});
+		auto last = first;
+		while (last != sortedPaths.end() && (*last)->first.starts_with(prefix)) {
+			++last;
+		}
+
+		auto matches = std::span(first, last);
+
+		std::vector<std::optional<AssetView>> views(matches.size());
+		ThreadPool::Instance()->parallel_for(matches.size(), [&](size_t i) {
+			views[i] = _view(matches[i]->second);
+		});
+
+		std::vector<AssetView> resources;
+		resources.reserve(views.size());
+		for (auto& view : views) {
+			if (view) {
+				resources.emplace_back(std::move(*view));
+			}
+		}
+		return std::move(resources);
+	}
+
+private:
+	static constexpr uint32_t EndOfCentralDirectorySignature = 0x06054b50;
+	static constexpr uint32_t CentralHeaderSignature = 0x02014b50;
+	static constexpr uint32_t LocalHeaderSignature = 0x04034b50;
+
+	static constexpr ptrdiff_t EndOfCentralDirectorySize = 22;
+	static constexpr ptrdiff_t CentralHeaderSize = 46;
+	static constexpr ptrdiff_t LocalHeaderSize = 30;
+
+	static constexpr uint16_t Stored = 0;
+	static constexpr uint16_t Deflated = 8;
+
+	static constexpr uint32_t Zip64Marker = 0xFFFFFFFF;
+
+	static constexpr std::string_view Manifest = "manifest.json";
+	static constexpr std::string_view ManifestSuffix = "/manifest.json";
+
+	struct Entry {
+		uint32_t headerOffset;
+		uint32_t storedSize;
+		uint32_t size;
+		uint16_t method;
+	};
+
+	static uint16_t _read16(const char* p) {
+		uint16_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	static uint32_t _read32(const char* p) {
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	// the record sits at the very end, followed only by an archive comment of up to 64k
+	const char* _findEndOfCentralDirectory() const {
+		if (archive->size < size_t(EndOfCentralDirectorySize)) {
+			return nullptr;
+		}
+
+		const auto* begin = archive->data;
+		const auto* last = begin + archive->size - EndOfCentralDirectorySize;
+		const auto* stop = last - std::min<ptrdiff_t>(last - begin, UINT16_MAX);
+		for (const auto* it = last; it >= stop; it--) {
+			if (_read32(it) == EndOfCentralDirectorySignature) {
+				return it;
+			}
+		}
+		return nullptr;
+	}
+
+	// the folder holding the pack's manifest.json, the shallowest one when there are several. nothing when
+	// the manifest sits at the root or there is none, a pack's own top level folders are never stripped
+	static std::string_view _commonRoot(const std::vector<std::pair<std::string, Entry>>& entries) {
+		std::optional<std::string_view> root;
+		for (auto& [path, entry] : entries) {
+			if (path == Manifest) {
+				return {};
+			}
+			if (path.ends_with(ManifestSuffix)) {
+				auto folder = std::string_view(path).substr(0, path.size() - Manifest.size());
+				if (!root || std::count(folder.begin(), folder.end(), '/') < std::count(root->begin(), root->end(), '/')) {
+					root = folder;
+				}
+			}
+		}
+		return root.value_or(std::string_view());
+	}
+
+	const Entry* _find(const std::filesystem::path& path) {
+		if (!indexed) {
+			index();
+		}
+
+		auto it = files.find(_key(path));
+		return it != files.end() ? &it->second : nullptr;
+	}
+
+	// the local header repeats the name and may carry a different extra field, only its lengths are needed
+	std::optional<AssetView> _view(const Entry& entry) const {
+		const auto* header = archive->data + entry.headerOffset;
+		if (uint64_t(entry.headerOffset) + LocalHeaderSize > archive->size || _read32(header) != LocalHeaderSignature) {
+			return std::nullopt;
+		}
+
+		const auto dataOffset = uint64_t(entry.headerOffset) + LocalHeaderSize + _read16(header + 26) + _read16(header + 28);
+		if (dataOffset + entry.storedSize > archive->size) {
+			return std::nullopt;
+		}
+
+		auto stored = std::span(archive->data + dataOffset, entry.storedSize);
+
+		if (entry.method == Stored) {
+			if (entry.storedSize != entry.size) {
+				return std::nullopt;
+			}
+			return AssetView(stored, archive);
+		}
+
+		if (entry.size > INT32_MAX || entry.storedSize > INT32_MAX) {
+			return std::nullopt;
+		}
+
+		std::string bytes(entry.size, '\0');
+		if (entry.size != 0) {
+			const auto length = stbi_zlib_decode_noheader_buffer(bytes.data(), int(bytes.size()), stored.data(), int(stored.size()));
+			if (length != int(entry.size)) {
+				return std::nullopt;
+			}
+		}
+		return AssetView::own(std::move(bytes));
+	}
+
+	std::filesystem::path archivePath;
+
+	bool indexed = false;
+	std::shared_ptr<MappedFile> archive;
+	int64_t archiveModified = 0;
+	std::unordered_map<std::string, Entry> files;
+	// sorted so that a directory's files form one contiguous range
+	std::vector<const std::pair<const std::string, Entry>*> sortedPaths;
+};
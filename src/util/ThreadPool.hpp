@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPool {
+	inline static ThreadPool* Instance() {
+		static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+		return &pool;
+	}
+
+	explicit ThreadPool(size_t count) {
+		workers.reserve(count);
+		for (size_t i = 0; i < count; i++) {
+			workers.emplace_back([this, i] {
+				_workerIndex = i;
+				_run();
+			});
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// number of worker threads, the thread that owns the pool is not counted
+	size_t size() const {
+		return workers.size();
+	}
+
+	// index of the calling thread in [0, size()], threads outside the pool share the last index
+	size_t threadIndex() const {
+		return _workerIndex != NotAWorker ? _workerIndex : workers.size();
+	}
+
+	template <typename Fn>
+	auto async(Fn&& fn) -> std::future<std::invoke_result_t<Fn>> {
+		using R = std::invoke_result_t<Fn>;
+
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<Fn>(fn));
+		auto future = task->get_future();
+		_push([task] { (*task)(); });
+		return future;
+	}
+
+	// calls fn(i) for every i in [0, count) and returns once all calls are done, the caller takes part in the work
+	template <typename Fn>
+	void parallel_for(size_t count, Fn&& fn) {
+		if (count == 0) {
+			return;
+		}
+
+		const auto tasks = std::min(count - 1, workers.size());
+
+		std::atomic_size_t next{0};
+		std::latch done{ptrdiff_t(tasks)};
+
+		auto work = [&next, &fn, count] {
+			for (size_t i = next++; i < count; i = next++) {
+				fn(i);
+			}
+		};
+
+		for (size_t i = 0; i < tasks; i++) {
+			_push([&work, &done] {
+				work();
+				done.count_down();
+			});
+		}
+
+		work();
+
+		// help with queued tasks instead of blocking, nested parallel_for calls from workers would deadlock otherwise
+		while (!done.try_wait()) {
+			if (!_runPending()) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+private:
+	inline static constexpr size_t NotAWorker = size_t(-1);
+	inline static thread_local size_t _workerIndex = NotAWorker;
+
+	void _push(std::function<void()> task) {
+		{
+			std::lock_guard lock(mutex);
+			tasks.emplace_back(std::move(task));
+		}
+		condition.notify_one();
+	}
+
+	bool _runPending() {
+		std::function<void()> task;
+		{
+			std::lock_guard lock(mutex);
+			if (tasks.empty()) {
+				return false;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+		return true;
+	}
+
+	void _run() {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock lock(mutex);
+				condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (stopping && tasks.empty()) {
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping = false;
+};
@@ -0,0 +1,166 @@
+// packs a resource pack directory into a single .vpack archive, see resources/PackArchive.hpp.
+//
+//   vcraft_pack <pack directory> <output.vpack> [--no-compress]
+
+#include "resources/PackArchive.hpp"
+#include "resources/Lz4.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PackFile {
+	std::string path;
+	std::vector<uint8_t> stored;
+	uint32_t size;
+	PackArchive::Compression compression;
+};
+
+// compression is kept only when it saves at least an eighth, already compressed formats like png rarely do
+static bool worthCompressing(size_t size, size_t compressedSize) {
+	return compressedSize + size / 8 <= size;
+}
+
+static bool readFile(const std::filesystem::path& path, std::vector<uint8_t>& bytes) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string_view> positional;
+	bool compress = true;
+	for (int i = 1; i < argc; i++) {
+		auto arg = std::string_view(argv[i]);
+		if (arg == "--no-compress") {
+			compress = false;
+		} else {
+			positional.emplace_back(arg);
+		}
+	}
+
+	if (positional.size() != 2) {
+		std::cerr << "usage: vcraft_pack <pack directory> <output.vpack> [--no-compress]" << std::endl;
+		return 1;
+	}
+
+	const auto source = std::filesystem::path(positional[0]);
+	const auto output = std::filesystem::path(positional[1]);
+
+	if (!std::filesystem::is_directory(source)) {
+		std::cerr << source << " is not a directory" << std::endl;
+		return 1;
+	}
+
+	std::vector<PackFile> files;
+	uint64_t totalSize = 0;
+	uint64_t totalStored = 0;
+
+	for (auto& entry : std::filesystem::recursive_directory_iterator(source)) {
+		if (!entry.is_regular_file()) {
+			continue;
+		}
+
+		PackFile file;
+		file.path = entry.path().lexically_relative(source).lexically_normal().generic_string();
+		file.compression = PackArchive::Compression::None;
+
+		if (!readFile(entry.path(), file.stored)) {
+			std::cerr << "failed to read " << entry.path() << std::endl;
+			return 1;
+		}
+		if (file.stored.size() > UINT32_MAX || file.path.size() > UINT16_MAX) {
+			std::cerr << "skipping " << entry.path() << ", too large for the archive format" << std::endl;
+			continue;
+		}
+		file.size = uint32_t(file.stored.size());
+
+		if (compress && !file.stored.empty()) {
+			auto compressed = Lz4::compress(file.stored);
+			if (worthCompressing(file.stored.size(), compressed.size())) {
+				file.stored = std::move(compressed);
+				file.compression = PackArchive::Compression::Lz4;
+			}
+		}
+
+		totalSize += file.size;
+		totalStored += file.stored.size();
+		files.emplace_back(std::move(file));
+	}
+
+	// the reader binary searches the entries by hash
+	std::sort(files.begin(), files.end(), [](const PackFile& a, const PackFile& b) {
+		auto ha = PackArchive::hashPath(a.path);
+		auto hb = PackArchive::hashPath(b.path);
+		return ha != hb ? ha < hb : a.path < b.path;
+	});
+
+	std::string paths;
+	std::vector<PackArchive::Entry> entries(files.size());
+
+	PackArchive::Header header{};
+	std::memcpy(header.magic, PackArchive::Magic, sizeof(header.magic));
+	header.version = PackArchive::Version;
+	header.entryCount = uint32_t(files.size());
+	header.entriesOffset = sizeof(PackArchive::Header);
+
+	for (size_t i = 0; i < files.size(); i++) {
+		entries[i].pathHash = PackArchive::hashPath(files[i].path);
+		entries[i].pathOffset = uint32_t(paths.size());
+		entries[i].pathLength = uint16_t(files[i].path.size());
+		paths += files[i].path;
+	}
+
+	header.pathsOffset = header.entriesOffset + entries.size() * sizeof(PackArchive::Entry);
+	header.pathBytes = uint32_t(paths.size());
+
+	uint64_t offset = PackArchive::align(header.pathsOffset + paths.size());
+	for (size_t i = 0; i < files.size(); i++) {
+		entries[i].offset = offset;
+		entries[i].storedSize = uint32_t(files[i].stored.size());
+		entries[i].size = files[i].size;
+		entries[i].compression = files[i].compression;
+		offset = PackArchive::align(offset + files[i].stored.size());
+	}
+
+	std::ofstream out(output, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cerr << "failed to open " << output << std::endl;
+		return 1;
+	}
+
+	uint64_t written = 0;
+	auto write = [&](const void* data, size_t size) {
+		out.write(static_cast<const char*>(data), std::streamsize(size));
+		written += size;
+	};
+	auto pad = [&](uint64_t to) {
+		static constexpr char zeros[PackArchive::Alignment] {};
+		write(zeros, to - written);
+	};
+
+	write(&header, sizeof(header));
+	write(entries.data(), entries.size() * sizeof(PackArchive::Entry));
+	write(paths.data(), paths.size());
+	for (size_t i = 0; i < files.size(); i++) {
+		pad(entries[i].offset);
+		write(files[i].stored.data(), files[i].stored.size());
+	}
+	pad(PackArchive::align(written));
+
+	if (!out) {
+		std::cerr << "failed to write " << output << std::endl;
+		return 1;
+	}
+
+	std::cout << "packed " << files.size() << " files, " << totalSize << " bytes stored as " << totalStored << " into " << output << " (" << written << " bytes)" << std::endl;
+	return 0;
+}